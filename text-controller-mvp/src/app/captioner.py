@@ -11,6 +11,8 @@ import threading
 import pyaudio
 import vosk
 
+import timeline
+
 MODEL_PATH = "vosk-model-small-en-us-0.15"
 
 _RATE = 16000
@@ -42,7 +44,7 @@ class Captioner:
         )
 
         # Vosk recognition runs on a second background thread
-        self._thread = threading.Thread(target=self._recognition_loop, daemon=True)
+        self._thread = threading.Thread(target=self._recognition_loop, name="vosk", daemon=True)
         self._thread.start()
 
     def _audio_callback(self, in_data, frame_count, time_info, status):
@@ -59,7 +61,9 @@ class Captioner:
             except queue.Empty:
                 continue
 
-            if self.recognizer.AcceptWaveform(data):
+            with timeline.span("stt_chunk"):
+                final = self.recognizer.AcceptWaveform(data)
+            if final:
                 result = json.loads(self.recognizer.Result())
                 text = result.get("text", "").upper()
                 if text:
@@ -0,0 +1,51 @@
+"""Compile the n-gram CSVs into the model file the C++ engine maps.
+
+    python3 compile_model.py [--data DIR] [-o MODEL]
+
+PredictiveText does this by itself when the model is missing or older
+than a CSV; run it by hand after editing the CSVs on a read-only install,
+or to see the model's size and load time.
+"""
+
+import argparse
+import sys
+import time
+from pathlib import Path
+
+import predictor
+
+APP_DIR = Path(__file__).resolve().parent
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    ap.add_argument("--data", default=str(APP_DIR / "data"), help="directory of the CSVs")
+    ap.add_argument("-o", "--output", help="model file (default: DATA/english.ngram)")
+    args = ap.parse_args()
+
+    if predictor._ngram is None:
+        print("C++ engine not built: run `make` in src/predict", file=sys.stderr)
+        return 1
+
+    data = Path(args.data)
+    paths = tuple(str(data / Path(p).name) for p in predictor.DEFAULT_PATHS)
+    out = args.output or str(data / Path(predictor.DEFAULT_MODEL).name)
+
+    t0 = time.perf_counter()
+    predictor.compile_model(out, paths)
+    t1 = time.perf_counter()
+    engine = predictor._ngram.Engine(out)
+    t2 = time.perf_counter()
+
+    info = engine.info()
+    print(f"{out}: format v{info['version']}, {info['bytes'] / 1024:.0f} KiB, "
+          f"{info['vocabulary']} words")
+    print(f"  trie: {info['trie_nodes']} nodes, {info['trie_top']} top-completion entries")
+    for n, (contexts, successors) in enumerate(zip(info["contexts"], info["successors"]), start=2):
+        print(f"  {n}-grams: {successors:>6} rows under {contexts:>6} contexts")
+    print(f"compiled in {(t1 - t0) * 1e3:.0f} ms, mapped in {(t2 - t1) * 1e6:.0f} us")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,204 @@
+"""Per-component CPU budget for the whole device.
+
+On battery, the useful question is which part of the system keeps the
+CPU busy or awake. Each report splits one interval into:
+
+    frames   the main loop: reading frames and AppState.update
+    render   scenes drawn into the OLED buffer       (main thread, by mark)
+    spi      SSD1309Driver.show                      (main thread, by mark)
+    reader   the threads reading the sensor's stdout and stderr
+    vosk     the captioner's recognition thread
+    piper    the TTS thread plus the piper and pacat processes it runs
+    sensor   the sensor binary, per thread, from its #CPU frames
+    other    the rest of the app process (PortAudio callbacks, GC, ...)
+
+Each is given as a share of one core, wake-ups per second (voluntary
+context switches, which keep the SoC out of its idle states) and
+preemptions per second. Only standard Linux interfaces are used. Threads
+are read through their CPU-time clocks (``time.pthread_getcpuclockid``)
+and ``/proc/self/task/TID/status``. Processes the app reaped during the
+interval come from ``getrusage(RUSAGE_CHILDREN)``, and the sensor reports
+its own threads. There is no power rail to measure, so CPU time and
+wake-ups stand in for power.
+
+App threads are matched by name (``THREAD_COMPONENTS``). The main loop
+brackets render and SPI with ``begin()`` and ``mark()``, as it does for
+LatencyTracer, and that CPU time moves from "frames" to those stages.
+"""
+
+import resource
+import threading
+import time
+
+REPORT_SEC = 60.0
+
+# Thread name -> component; unlisted threads count as "other"
+THREAD_COMPONENTS = {
+    "MainThread":    "frames",
+    "sensor-reader": "reader",
+    "sensor-stderr": "reader",
+    "vosk":          "vosk",
+    "tts":           "piper",
+}
+
+COMPONENTS = ("frames", "render", "spi", "reader", "vosk", "piper", "sensor", "other")
+
+
+def _switches(native_id: int) -> tuple[int, int]:
+    """(voluntary, involuntary) context switches of one of our threads."""
+    vol = invol = 0
+    try:
+        with open(f"/proc/self/task/{native_id}/status") as f:
+            for line in f:
+                if line.startswith("voluntary_ctxt_switches:"):
+                    vol = int(line.split()[1])
+                elif line.startswith("nonvoluntary_ctxt_switches:"):
+                    invol = int(line.split()[1])
+    except (OSError, ValueError):
+        pass
+    return vol, invol
+
+
+def _parse_sensor(info: dict[str, str]) -> tuple[int, dict[str, tuple[float, int, int]]]:
+    """#CPU frame -> (uptime_ms, {thread or "process": (cpu_ms, vol, invol)})."""
+    usage = {}
+    for key, value in info.items():
+        parts = value.split("/")
+        if len(parts) == 3:
+            usage[key] = (float(parts[0]), int(parts[1]), int(parts[2]))
+    return int(info.get("uptime_ms", 0)), usage
+
+
+class CpuBudget:
+    def __init__(self, report_sec: float = REPORT_SEC, sensor_cpu=None):
+        """``sensor_cpu`` returns the sensor's latest #CPU frame (a dict), or None."""
+        self._report_sec = report_sec
+        self._sensor_cpu = sensor_cpu
+        self._marked: dict[str, int] = {}           # stage -> ns this interval
+        self._mark_ns = 0
+        self._sensor: tuple[int, dict] | None = None
+        self._sensor_reaped_ms = 0.0
+        self._prev = self._snapshot()
+        self._last_report = time.monotonic()
+
+    # ── Main-loop stages ─────────────────────────────────────────────────────
+
+    def begin(self):
+        self._mark_ns = time.thread_time_ns()
+
+    def mark(self, stage: str):
+        """Charge the calling thread's CPU since the last begin/mark to ``stage``."""
+        now = time.thread_time_ns()
+        self._marked[stage] = self._marked.get(stage, 0) + now - self._mark_ns
+        self._mark_ns = now
+
+    # ── Sampling ─────────────────────────────────────────────────────────────
+
+    def _snapshot(self) -> dict:
+        threads = {}
+        for t in threading.enumerate():
+            try:
+                cpu_ns = time.clock_gettime_ns(time.pthread_getcpuclockid(t.ident))
+            except (OSError, TypeError):
+                continue                    # exited, or not started yet
+            threads[t.native_id] = (THREAD_COMPONENTS.get(t.name, "other"), cpu_ns,
+                                    *_switches(t.native_id))
+        own = resource.getrusage(resource.RUSAGE_SELF)
+        kids = resource.getrusage(resource.RUSAGE_CHILDREN)
+        return {
+            "mono": time.monotonic(),
+            "process": (time.process_time_ns(), own.ru_nvcsw, own.ru_nivcsw),
+            "children": ((kids.ru_utime + kids.ru_stime) * 1e9, kids.ru_nvcsw, kids.ru_nivcsw),
+            "threads": threads,
+        }
+
+    def _sensor_delta(self) -> dict[str, tuple[float, int, int, float]]:
+        """thread -> (cpu_ms, vol, invol, interval_ms) since the last report."""
+        frame = self._sensor_cpu() if self._sensor_cpu else None
+        if not frame:
+            return {}
+        uptime, usage = _parse_sensor(frame)
+        prev = self._sensor
+        if prev and uptime < prev[0]:
+            # New sensor process: the old one's total went to RUSAGE_CHILDREN
+            self._sensor_reaped_ms += prev[1].get("process", (0.0, 0, 0))[0]
+            prev = None
+        self._sensor = (uptime, usage)
+        base_uptime, base = prev if prev else (0, {})
+        span = uptime - base_uptime
+        if span <= 0:
+            return {}
+        zero = (0.0, 0, 0)
+        delta = {name: (u[0] - base.get(name, zero)[0], u[1] - base.get(name, zero)[1],
+                        u[2] - base.get(name, zero)[2], span)
+                 for name, u in usage.items()}
+        # The process first, then its threads
+        return dict(sorted(delta.items(), key=lambda kv: kv[0] != "process"))
+
+    def report(self) -> dict:
+        """component -> (cpu %, wake-ups/s, preemptions/s) since the last report.
+
+        The sensor's threads appear as "sensor/NAME"; stages that were
+        marked have no switch counts of their own (None).
+        """
+        cur, prev = self._snapshot(), self._prev
+        self._prev = cur
+        wall = max(cur["mono"] - prev["mono"], 1e-9)
+        ns = {c: 0.0 for c in COMPONENTS}
+        vol = {c: 0 for c in COMPONENTS}
+        invol = {c: 0 for c in COMPONENTS}
+
+        tracked = 0.0
+        for tid, (comp, cpu_ns, v, i) in cur["threads"].items():
+            old = prev["threads"].get(tid, (comp, 0, 0, 0))
+            ns[comp] += cpu_ns - old[1]
+            vol[comp] += v - old[2]
+            invol[comp] += i - old[3]
+            tracked += cpu_ns - old[1]
+        ns["other"] += max(0.0, cur["process"][0] - prev["process"][0] - tracked)
+
+        for stage in ("render", "spi"):
+            charged = self._marked.pop(stage, 0)
+            ns[stage] += charged
+            ns["frames"] = max(0.0, ns["frames"] - charged)
+        self._marked.clear()
+
+        out = {}
+        sensor = self._sensor_delta()
+        reaped_ms, self._sensor_reaped_ms = self._sensor_reaped_ms, 0.0
+        kids = [c - p for c, p in zip(cur["children"], prev["children"])]
+        ns["piper"] += max(0.0, kids[0] - reaped_ms * 1e6)
+        vol["piper"] += kids[1]
+        invol["piper"] += kids[2]
+        for comp in COMPONENTS:
+            if comp == "sensor":
+                for name, (cpu_ms, v, i, span_ms) in sensor.items():
+                    key = "sensor" if name == "process" else f"sensor/{name}"
+                    out[key] = (100.0 * cpu_ms / span_ms, v * 1e3 / span_ms, i * 1e3 / span_ms)
+                continue
+            marked = comp in ("render", "spi")
+            out[comp] = (100.0 * ns[comp] / 1e9 / wall,
+                         None if marked else vol[comp] / wall,
+                         None if marked else invol[comp] / wall)
+        return out
+
+    def maybe_report(self, log=print) -> bool:
+        """Log the budget every ``report_sec``; True if it did."""
+        now = time.monotonic()
+        if now - self._last_report < self._report_sec:
+            return False
+        span = now - self._last_report
+        self._last_report = now
+        log(format_report(self.report(), span))
+        return True
+
+
+def format_report(report: dict, seconds: float) -> str:
+    total = sum(cpu for name, (cpu, _, _) in report.items() if "/" not in name)
+    lines = [f"CPU budget over {seconds:.0f} s: {total:.1f}% of one core"
+             f" (% core, wake-ups/s, preemptions/s)"]
+    for name, (cpu, vol, invol) in report.items():
+        label = "  " + name.split("/")[1] if "/" in name else name
+        rates = "" if vol is None else f" {vol:8.1f} {invol:8.1f}"
+        lines.append(f"  {label:<10} {cpu:6.2f}%{rates}")
+    return "\n".join(lines)
@@ -0,0 +1,112 @@
+"""End-to-end latency tracing: head movement to pixels on the OLED.
+
+Every data frame carries a trace id (``seq``) and two sensor-side stamps:
+``t_us`` when the I2C read started and ``tx_us`` when the frame was
+formatted. Both are CLOCK_MONOTONIC, the clock behind
+``time.monotonic_ns()``, so the app stamps the remaining stages on the same
+timeline and each displayed frame yields one complete trace:
+
+    sensor   acquisition -> frame formatted     (read, math, filter, format)
+    pipe     formatted   -> parsed by SerialReader
+    queue    parsed      -> picked up by the main loop
+    update   AppState.update
+    render   scene drawn into the OLED buffer
+    show     SSD1309Driver.show (SPI transfer)
+
+Frames the main loop never picks up (overwritten by a newer one) are not
+traced: only frames that reach the display count. Recording costs a few
+clock reads and deque appends per displayed frame, so it stays on. The
+update, render and show stamps also go to the timeline (``timeline.py``).
+"""
+
+import time
+from collections import deque
+from typing import NamedTuple, Optional
+
+import timeline
+
+STAGES = ("sensor", "pipe", "queue", "update", "render", "show")
+
+WINDOW_FRAMES = 4096       # ~1 min at 60 fps
+REPORT_SEC    = 30.0
+
+
+class FrameTrace(NamedTuple):
+    """Stamps collected by SerialReader for one data frame (ns)."""
+    seq: int
+    acquired_ns: Optional[int]     # None when the sensor clock is not ours
+    formatted_ns: Optional[int]
+    received_ns: int
+
+
+class LatencyTracer:
+    def __init__(self, window: int = WINDOW_FRAMES, report_sec: float = REPORT_SEC):
+        self._report_sec = report_sec
+        self._stages = {s: deque(maxlen=window) for s in STAGES}
+        self._total = deque(maxlen=window)
+        self._trace: Optional[FrameTrace] = None
+        self._marks: dict[str, int] = {}
+        self._last_report = time.monotonic()
+        self.traced = 0
+        self.last_seq = -1
+
+    def begin(self, trace: Optional[FrameTrace]):
+        """The main loop picked up the frame behind ``trace``."""
+        self._trace = trace
+        self._marks = {"queue": time.monotonic_ns()} if trace else {}
+
+    def mark(self, stage: str):
+        """``stage`` (update, render, show) just finished."""
+        if self._trace is not None:
+            self._marks[stage] = time.monotonic_ns()
+
+    def end(self):
+        t, m = self._trace, self._marks
+        self._trace = None
+        if t is None or "show" not in m:
+            return
+        prev = t.received_ns
+        if t.acquired_ns is not None and t.formatted_ns is not None:
+            self._stages["sensor"].append(t.formatted_ns - t.acquired_ns)
+            self._stages["pipe"].append(t.received_ns - t.formatted_ns)
+            start = t.acquired_ns
+        else:
+            start = t.received_ns
+        for stage in ("queue", "update", "render", "show"):
+            if stage in m:
+                self._stages[stage].append(m[stage] - prev)
+                if stage != "queue":
+                    timeline.complete(stage, prev, m[stage])
+                prev = m[stage]
+        self._total.append(m["show"] - start)
+        self.traced += 1
+        self.last_seq = t.seq
+
+    def report(self) -> dict[str, tuple[float, float, float]]:
+        """stage -> (p50, p99, max) in ms over the window, plus "total"."""
+        out = {"total": _percentiles(self._total)} if self._total else {}
+        for name, values in self._stages.items():
+            if values:
+                out[name] = _percentiles(values)
+        return out
+
+    def maybe_report(self, log=print) -> bool:
+        """Log a one-line summary every ``report_sec``; True if it did."""
+        now = time.monotonic()
+        if now - self._last_report < self._report_sec or not self._total:
+            return False
+        self._last_report = now
+        log(format_report(self.report(), len(self._total)))
+        return True
+
+
+def _percentiles(values) -> tuple[float, float, float]:
+    s = sorted(values)
+    n = len(s)
+    return (s[n // 2] / 1e6, s[min(n - 1, n * 99 // 100)] / 1e6, s[-1] / 1e6)
+
+
+def format_report(report: dict[str, tuple[float, float, float]], frames: int) -> str:
+    parts = [f"{name} {p50:.2f}/{p99:.2f}/{mx:.2f}"
+             for name, (p50, p99, mx) in report.items()]
+    return f"Latency ms p50/p99/max over {frames} frames: " + " | ".join(parts)
@@ -4,7 +4,10 @@ import time
 import signal
 import sys
 
-from serial_reader import SerialReader
+import timeline
+from cpu_budget import CpuBudget
+from latency import LatencyTracer
+from serial_reader import SENSOR_BINARY, SerialReader
 from app_state import AppState, MODE_WRITE
 from oled_driver import OLEDBuffer, SSD1309Driver
 
@@ -48,6 +51,8 @@ def main():
     state.on_restart_sensor = reader.restart
     oled = OLEDBuffer()
     driver = SSD1309Driver()
+    tracer = LatencyTracer()
+    budget = CpuBudget(sensor_cpu=lambda: reader.last_cpu)
 
     # Graceful shutdown on Ctrl-C or SIGTERM
     def _shutdown(sig=None, frame=None):
@@ -59,6 +64,20 @@ def main():
     signal.signal(signal.SIGINT,  _shutdown)
     signal.signal(signal.SIGTERM, _shutdown)
 
+    # SIGUSR1: dump the sensor's trace and ours onto one timeline. The
+    # sensor answers on the reader thread, which does the conversion.
+    def _write_timeline(sensor_dump):
+        events = timeline.load_sensor_trace(SENSOR_BINARY, sensor_dump) if sensor_dump else []
+        n = timeline.dump(timeline.TIMELINE_PATH, events)
+        print(f"Timeline: {n} events in {timeline.TIMELINE_PATH}")
+
+    def _request_timeline(sig=None, frame=None):
+        if not reader.send_command("TRACE"):
+            _write_timeline(None)       # sensor not running: app events only
+
+    reader.on_trace_dump = _write_timeline
+    signal.signal(signal.SIGUSR1, _request_timeline)
+
     # Initial calibration run on startup
     _run_calibration(driver, oled, reader)
 
@@ -76,10 +95,20 @@ def main():
             _run_calibration(driver, oled, reader)
             continue
 
+        problem = reader.check_health()
+        if problem:
+            # The user hasn't moved, so keep the saved calibration
+            print(f"Sensor unhealthy ({problem}) — restarting")
+            reader.restart(warm=True)
+            continue
+
         data = reader.read_latest()
         if data is not None:
             roll, pitch = data
+            tracer.begin(reader.trace)
             state.update(roll, pitch)
+            tracer.mark("update")
+            budget.begin()
 
             s = state
             inp = s.input
@@ -103,8 +132,16 @@ def main():
                     direction=inp.direction,
                     dwell_percent=s.dwell_percent,
                 )
+            tracer.mark("render")
+            budget.mark("render")
 
             driver.show(oled)
+            tracer.mark("show")
+            budget.mark("spi")
+            tracer.end()
+
+        tracer.maybe_report()
+        budget.maybe_report()
 
         time.sleep(LOOP_DELAY_S)
 
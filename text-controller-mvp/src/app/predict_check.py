@@ -0,0 +1,151 @@
+"""Check the C++ prediction engine against the Python one, and time both.
+
+    python3 predict_check.py [--phrases FILE] [--limit N] [--seed N]
+
+The test corpus is every row of the n-gram CSVs read as a sentence,
+plus any phrases given, one per line. Each word of each sentence is
+queried the way AppState asks while it is being typed: the words before
+it as context, then every prefix from empty to whole. Random prefixes,
+unknown context words, odd spacing and lower case are mixed in, and
+max_results takes values from 0 to 10.
+
+Both engines must return identical (suggestions, level, context)
+tuples, and the script exits 1 on any difference. Per-call latency is
+the median over the queries at max_results=3, the app's setting.
+
+Last comes the Python dicts' side of `make bench` in src/predict: bytes
+per n-gram (dict, key tuples, lists and strings, each object counted
+once) and ns per context lookup.
+"""
+
+import argparse
+import random
+import statistics
+import sys
+import time
+from pathlib import Path
+
+import predictor
+from predictor import PredictiveText
+
+DATA = Path(__file__).resolve().parent / "data"
+MAX_RESULTS = (0, 1, 2, 3, 5, 10)
+
+
+def corpus_sentences(phrases: str | None) -> list[list[str]]:
+    sentences = []
+    for n in range(2, 6):
+        with open(DATA / f"{n}grams_english.csv", encoding="utf-8") as f:
+            next(f)
+            sentences += [line.rsplit(",", 1)[0].split() for line in f]
+    if phrases:
+        with open(phrases, encoding="utf-8") as f:
+            sentences += [line.split() for line in f if line.strip()]
+    return sentences
+
+
+def queries(sentences: list[list[str]], rng: random.Random):
+    """(current_input, context, max_results) in the shapes the app produces."""
+    letters = "ABCDEFGHIJKLMNOPQRSTUVWXYZ'"
+    for words in sentences:
+        for i, word in enumerate(words):
+            context = " ".join(words[:i])
+            for j in range(len(word) + 1):
+                yield word[:j], context, 3
+            yield word, context.lower(), rng.choice(MAX_RESULTS)
+            yield f"  {word[:2]} ", f" {context}  ", rng.choice(MAX_RESULTS)
+            junk = "".join(rng.choice(letters) for _ in range(rng.randint(1, 4)))
+            yield junk, context, rng.choice(MAX_RESULTS)
+            yield word[:1], f"{context} QXZV", 3
+
+
+def deep_size(obj, seen: set) -> int:
+    if id(obj) in seen:
+        return 0
+    seen.add(id(obj))
+    size = sys.getsizeof(obj)
+    if isinstance(obj, dict):
+        size += sum(deep_size(k, seen) + deep_size(v, seen) for k, v in obj.items())
+    elif isinstance(obj, (list, tuple)):
+        size += sum(deep_size(x, seen) for x in obj)
+    return size
+
+
+def fresh(word: str) -> str:
+    return word.encode().decode()
+
+
+def dict_report(python: PredictiveText) -> None:
+    """Memory and lookup cost of the Python context tables."""
+    tables = (python.bigrams, python.trigrams, python.quadrigrams, python.pentagrams)
+    for n, table in enumerate(tables, start=2):
+        rows = sum(len(v) for v in table.values())
+        size = deep_size(table, set())
+        get = table.get
+        per = []
+        for _ in range(7):
+            # New strings each round, as get_suggestions splits them from the
+            # context: no cached hashes
+            keys = [fresh(k) if isinstance(k, str) else tuple(map(fresh, k)) for k in table]
+            start = time.perf_counter_ns()
+            for k in keys:
+                get(k)
+            mid = time.perf_counter_ns()
+            for k in keys:
+                pass
+            per.append((2 * mid - start - time.perf_counter_ns()) / len(keys))
+        print(f"  {n}-grams: {size / rows:6.1f} B per n-gram, "
+              f"{statistics.median(per):5.1f} ns per dict lookup")
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    ap.add_argument("--phrases", help="extra sentences, one per line")
+    ap.add_argument("--limit", type=int, help="stop after N queries")
+    ap.add_argument("--seed", type=int, default=1)
+    args = ap.parse_args()
+
+    if predictor._ngram is None:
+        print("C++ engine not built: run `make` in src/predict", file=sys.stderr)
+        return 1
+
+    t0 = time.perf_counter()
+    python = PredictiveText(native=False)
+    t1 = time.perf_counter()
+    native = PredictiveText()
+    t2 = time.perf_counter()
+    print(f"load: Python {(t1 - t0) * 1e3:.0f} ms from the CSVs, "
+          f"C++ {(t2 - t1) * 1e3:.1f} ms from the compiled model")
+
+    rng = random.Random(args.seed)
+    todo = list(queries(corpus_sentences(args.phrases), rng))[:args.limit]
+
+    mismatches = 0
+    for q in todo:
+        want, got = python.get_suggestions(*q), native.get_suggestions(*q)
+        if want != got:
+            mismatches += 1
+            if mismatches <= 10:
+                print(f"MISMATCH {q!r}: python {want!r}, C++ {got!r}")
+
+    timed = [q for q in todo if q[2] == 3]
+    for name, engine in (("Python", python), ("C++", native)):
+        samples = []
+        for q in timed:
+            start = time.perf_counter_ns()
+            engine.get_suggestions(*q)
+            samples.append(time.perf_counter_ns() - start)
+        samples.sort()
+        print(f"{name:>6}: median {statistics.median(samples) / 1e3:7.2f} us, "
+              f"p99 {samples[len(samples) * 99 // 100] / 1e3:7.2f} us, "
+              f"max {samples[-1] / 1e3:8.2f} us per call")
+
+    print("Python context tables (compare `make bench` in src/predict):")
+    dict_report(python)
+
+    print(f"{len(todo)} queries, {mismatches} mismatches")
+    return 1 if mismatches else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,17 +1,83 @@
 """Frequency-ranked, context-aware word prediction using n-gram CSVs."""
 
 import csv
+import os
+import sys
 from collections import defaultdict
+from pathlib import Path
+
+# The C++ engine from src/predict (`make` there); get_suggestions falls
+# back to the Python code below without it
+_NATIVE_DIR = str(Path(__file__).resolve().parent.parent / "predict")
+sys.path.insert(0, _NATIVE_DIR)
+try:
+    import _ngram
+except ImportError:
+    _ngram = None
+finally:
+    sys.path.remove(_NATIVE_DIR)
+
+DEFAULT_PATHS = (
+    "data/1grams_english.csv",
+    "data/2grams_english.csv",
+    "data/3grams_english.csv",
+    "data/4grams_english.csv",
+    "data/5grams_english.csv",
+)
+DEFAULT_MODEL = "data/english.ngram"
+
+# Used when the 1-gram CSV is missing
+FALLBACK_UNIGRAMS = ["THE", "AND", "YOU", "THAT", "WAS",
+                     "FOR", "ARE", "WITH", "THIS", "HAVE"]
+
+
+def read_ngram_csv(path: str):
+    """Yield (ngram, freq) per row of an orgtre CSV (columns: ngram, freq[, ...]),
+    the n-gram stripped and upper-cased. Raises FileNotFoundError."""
+    with open(path, newline="", encoding="utf-8") as f:
+        for row in csv.DictReader(f):
+            yield row["ngram"].strip().upper(), int(row["freq"])
+
+
+def compile_model(model_path: str, paths=DEFAULT_PATHS) -> None:
+    """Compile the 1..5-gram CSVs at `paths` into a model file for the C++
+    engine. Rows are read and filtered exactly as the Python loaders do."""
+    try:
+        unigrams = [(w, freq) for w, freq in read_ngram_csv(paths[0]) if w]
+    except FileNotFoundError:
+        unigrams = [(w, 0) for w in FALLBACK_UNIGRAMS]
+    ngrams = []
+    for n, path in enumerate(paths[1:], start=2):
+        rows = []
+        try:
+            for ngram, freq in read_ngram_csv(path):
+                parts = tuple(ngram.split())
+                if len(parts) == n:
+                    rows.append((parts, freq))
+        except FileNotFoundError:
+            pass
+        ngrams.append(rows)
+    _ngram.compile(model_path, unigrams, ngrams)
+
+
+def _model_is_stale(model_path: str, paths) -> bool:
+    try:
+        built = os.stat(model_path).st_mtime_ns
+    except FileNotFoundError:
+        return True
+    return any(os.path.exists(p) and os.stat(p).st_mtime_ns > built for p in paths)
 
 
 class PredictiveText:
     def __init__(
         self,
-        unigram_path: str = "data/1grams_english.csv",
-        bigram_path: str = "data/2grams_english.csv",
-        trigram_path: str = "data/3grams_english.csv",
-        quadrigram_path: str = "data/4grams_english.csv",
-        pentagram_path: str = "data/5grams_english.csv",
+        unigram_path: str = DEFAULT_PATHS[0],
+        bigram_path: str = DEFAULT_PATHS[1],
+        trigram_path: str = DEFAULT_PATHS[2],
+        quadrigram_path: str = DEFAULT_PATHS[3],
+        pentagram_path: str = DEFAULT_PATHS[4],
+        native: bool = True,
+        model_path: str = DEFAULT_MODEL,
     ):
         # List of (word,) tuples sorted by frequency — for prefix fallback
         self.unigrams: list[str] = []
@@ -28,12 +94,37 @@ class PredictiveText:
         # { ("word1", "word2", "word3", "word4"): ["word5a", "word5b\", ...] }  (pre-sorted by freq)
         self.pentagrams: dict[tuple[str, str, str, str], list[str]] = defaultdict(list)
 
+        # The C++ engine maps a compiled model instead of building the
+        # tables above; same answers (predict_check.py)
+        paths = (unigram_path, bigram_path, trigram_path, quadrigram_path, pentagram_path)
+        self._engine = self._open_model(model_path, paths) if native else None
+        if self._engine is not None:
+            return
+
         self._load_unigrams(unigram_path)
         self._load_bigrams(bigram_path)
         self._load_trigrams(trigram_path)
         self._load_quadrigrams(quadrigram_path)
         self._load_pentagrams(pentagram_path)
 
+    @staticmethod
+    def _open_model(model_path: str, paths):
+        """Map the model, compiling it first when missing, older than a CSV
+        or of another format version. None if that is not possible."""
+        if _ngram is None:
+            return None
+        try:
+            if not _model_is_stale(model_path, paths):
+                try:
+                    return _ngram.Engine(model_path)
+                except ValueError:
+                    pass
+            compile_model(model_path, paths)
+            return _ngram.Engine(model_path)
+        except (OSError, ValueError) as e:
+            print(f"No compiled n-gram model ({e}); using the CSVs")
+            return None
+
     # ------------------------------------------------------------------ #
     #  Loaders                                                             #
     # ------------------------------------------------------------------ #
@@ -41,65 +132,53 @@ class PredictiveText:
     def _load_unigrams(self, path: str) -> None:
         """Load 1-grams; orgtre CSV has columns: ngram, freq, cumshare[, en]"""
         try:
-            with open(path, newline="", encoding="utf-8") as f:
-                reader = csv.DictReader(f)
-                for row in reader:
-                    word = row["ngram"].strip().upper()
-                    if word:
-                        self.unigrams.append(word)
+            for word, _ in read_ngram_csv(path):
+                if word:
+                    self.unigrams.append(word)
         except FileNotFoundError:
-            self.unigrams = ["THE", "AND", "YOU", "THAT", "WAS",
-                             "FOR", "ARE", "WITH", "THIS", "HAVE"]
+            self.unigrams = list(FALLBACK_UNIGRAMS)
 
     def _load_bigrams(self, path: str) -> None:
         """Load 2-grams; orgtre CSV has columns: ngram, freq"""
         try:
-            with open(path, newline="", encoding="utf-8") as f:
-                reader = csv.DictReader(f)
-                for row in reader:
-                    parts = row["ngram"].strip().upper().split()
-                    if len(parts) == 2:
-                        w1, w2 = parts
-                        self.bigrams[w1].append(w2)
+            for ngram, _ in read_ngram_csv(path):
+                parts = ngram.split()
+                if len(parts) == 2:
+                    w1, w2 = parts
+                    self.bigrams[w1].append(w2)
         except FileNotFoundError:
             pass
 
     def _load_trigrams(self, path: str) -> None:
         """Load 3-grams; orgtre CSV has columns: ngram, freq"""
         try:
-            with open(path, newline="", encoding="utf-8") as f:
-                reader = csv.DictReader(f)
-                for row in reader:
-                    parts = row["ngram"].strip().upper().split()
-                    if len(parts) == 3:
-                        w1, w2, w3 = parts
-                        self.trigrams[(w1, w2)].append(w3)
+            for ngram, _ in read_ngram_csv(path):
+                parts = ngram.split()
+                if len(parts) == 3:
+                    w1, w2, w3 = parts
+                    self.trigrams[(w1, w2)].append(w3)
         except FileNotFoundError:
             pass
 
     def _load_quadrigrams(self, path: str) -> None:
         """Load 4-grams; orgtre CSV has columns: ngram, freq"""
         try:
-            with open(path, newline="", encoding="utf-8") as f:
-                reader = csv.DictReader(f)
-                for row in reader:
-                    parts = row["ngram"].strip().upper().split()
-                    if len(parts) == 4:
-                        w1, w2, w3, w4 = parts
-                        self.quadrigrams[(w1, w2, w3)].append(w4)
+            for ngram, _ in read_ngram_csv(path):
+                parts = ngram.split()
+                if len(parts) == 4:
+                    w1, w2, w3, w4 = parts
+                    self.quadrigrams[(w1, w2, w3)].append(w4)
         except FileNotFoundError:
             pass
 
     def _load_pentagrams(self, path: str) -> None:
         """Load 5-grams; orgtre CSV has columns: ngram, freq"""
         try:
-            with open(path, newline="", encoding="utf-8") as f:
-                reader = csv.DictReader(f)
-                for row in reader:
-                    parts = row["ngram"].strip().upper().split()
-                    if len(parts) == 5:
-                        w1, w2, w3, w4, w5 = parts
-                        self.pentagrams[(w1, w2, w3, w4)].append(w5)
+            for ngram, _ in read_ngram_csv(path):
+                parts = ngram.split()
+                if len(parts) == 5:
+                    w1, w2, w3, w4, w5 = parts
+                    self.pentagrams[(w1, w2, w3, w4)].append(w5)
         except FileNotFoundError:
             pass
 
@@ -121,6 +200,18 @@ class PredictiveText:
               - level        is "3G", "2G", "1G", or "—"
               - context_words is the word(s) used as the lookup key, or ""
         """
+        if self._engine is not None:
+            return self._engine.suggest(
+                current_input.strip().upper(), context.upper().split(), max_results
+            )
+        return self._get_suggestions_py(current_input, context, max_results)
+
+    def _get_suggestions_py(
+        self,
+        current_input: str,
+        context: str = "",
+        max_results: int = 3,
+    ) -> tuple[list[str], str, str]:
         prefix = current_input.strip().upper()
         prev_words = context.strip().upper().split() if context.strip() else []
 
@@ -0,0 +1,335 @@
+"""Accelerated replay of a recorded session through the whole stack.
+
+    python3 replay_sim.py SESSION.rec [--mode write] [--no-render]
+                                      [--events] [--json OUT] [--sensor PATH]
+
+The sensor binary replays the recording unpaced (``--replay-speed 0``).
+That is the same calibration, filter and output code that runs live.
+Its frames carry the recorded ``t_us`` and drive InputProcessor, AppState
+and the OLED renderer under a virtual clock. Recorded time replaces
+``time.time()``, and main.py's LOOP_DELAY_S sleep only advances the clock.
+Dwell timers, cooldowns and the main loop's pick-the-latest-frame
+behaviour play out as they did live, only as fast as the CPU allows.
+
+Audio (Vosk, Piper) and the SPI panel are stubbed. Phrases that would be
+spoken are counted as sent messages. The report covers the actions taken,
+the throughput of each stage, and how many times faster than real time
+the run was.
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import time
+import types
+from pathlib import Path
+
+APP_DIR = Path(__file__).resolve().parent
+
+# Must match main.py: the simulated loop picks up frames at this cadence
+LOOP_DELAY_S = 0.016
+
+
+# ── Stubs and the virtual clock ──────────────────────────────────────────────
+
+class VirtualClock:
+    """Stands in for the ``time`` module inside the app's modules."""
+
+    def __init__(self, now: float = 0.0):
+        self.now = now
+
+    def time(self) -> float:
+        return self.now
+
+    monotonic = time
+
+    def sleep(self, seconds: float):
+        self.now += seconds
+
+
+class _StubCaptioner:
+    def __init__(self, *args, **kwargs):
+        self.transcript: list[str] = []
+        self.partial = ""
+        self.paused = False
+
+    def update(self):
+        pass
+
+    def toggle_pause(self):
+        self.paused = not self.paused
+
+    def clear(self):
+        self.transcript.clear()
+        self.partial = ""
+
+    def get_last_word(self) -> str:
+        return ""
+
+    def close(self):
+        pass
+
+
+class _StubTTS:
+    def __init__(self, *args, **kwargs):
+        self.spoken: list[str] = []
+
+    def speak(self, text: str):
+        self.spoken.append(text)
+
+    def clear(self):
+        pass
+
+
+def install_stubs():
+    """Replace audio and display hardware modules before the app imports them."""
+    captioner = types.ModuleType("captioner")
+    captioner.Captioner = _StubCaptioner
+    tts = types.ModuleType("tts")
+    tts.TTSQueue = _StubTTS
+    waveshare = types.ModuleType("waveshare_OLED")
+    waveshare.OLED_1in51 = types.ModuleType("waveshare_OLED.OLED_1in51")
+    sys.modules.update({"captioner": captioner, "tts": tts, "waveshare_OLED": waveshare})
+
+
+# ── Stages ───────────────────────────────────────────────────────────────────
+
+class Stage:
+    def __init__(self, name: str):
+        self.name = name
+        self.ops = 0
+        self.ns = 0
+
+    def add(self, ns: int, ops: int = 1):
+        self.ns += ns
+        self.ops += ops
+
+    def report(self) -> dict:
+        return {
+            "ops": self.ops,
+            "seconds": self.ns / 1e9,
+            "us_per_op": self.ns / 1e3 / self.ops if self.ops else 0.0,
+            "ops_per_s": self.ops * 1e9 / self.ns if self.ns else 0.0,
+        }
+
+
+def run_sensor(binary: Path, recording: str, stage: Stage) -> list[tuple[float, float, float]]:
+    """C++ side: (t_s, roll, pitch) for every frame the binary would stream."""
+    t0 = time.perf_counter_ns()
+    out = subprocess.run(
+        [str(binary), "--replay", recording, "--replay-speed", "0",
+         "--fields", "t_us,roll,pitch", "--health-ms", "0",
+         "--state", "none", "--trace-events", "0"],
+        stdin=subprocess.DEVNULL, capture_output=True, text=True, check=True,
+    ).stdout
+    lines = out.splitlines()
+    stage.add(time.perf_counter_ns() - t0, sum(1 for l in lines if l and l[0] != "#"))
+
+    fields: tuple[str, ...] = ()
+    frames = []
+    for line in lines:
+        if line.startswith("#HELLO"):
+            for tok in line.split()[1:]:
+                if tok.startswith("fields="):
+                    fields = tuple(tok[7:].split(","))
+        elif line and line[0] != "#":
+            f = dict(zip(fields, map(float, line.split(","))))
+            frames.append((f["t_us"] / 1e6, f["roll"], f["pitch"]))
+    return frames
+
+
+# ── Action accounting ────────────────────────────────────────────────────────
+
+class ActionLog:
+    """Wraps AppState's action methods to count what the session did."""
+
+    def __init__(self, state, clock: VirtualClock, t0: float):
+        self.counts: dict[str, int] = {}
+        self.events: list[tuple[float, str, str]] = []
+        self._state = state
+        self._clock = clock
+        self._t0 = t0
+
+        from font import ALPHABET
+        self._alphabet = ALPHABET
+        self._wrap("_select_current", self._on_select)
+        self._wrap("_accept_top_suggestion", self._on_accept_top)
+        self._wrap("_delete_word", lambda before: self.add("word_deleted", ""))
+        self._wrap("_send_message", self._on_send)
+
+    def _wrap(self, name: str, after):
+        original = getattr(self._state, name)
+
+        def wrapped(*args, **kwargs):
+            before = (self._state.sentence, self._state.prefix, self._state.sugg_index,
+                      list(self._state.suggestions), self._state.cursor_index)
+            result = original(*args, **kwargs)
+            after(before)
+            return result
+        setattr(self._state, name, wrapped)
+
+    def add(self, action: str, detail: str):
+        self.counts[action] = self.counts.get(action, 0) + 1
+        self.events.append((self._clock.now - self._t0, action, detail))
+
+    def _on_select(self, before):
+        _, _, sugg_index, suggestions, cursor = before
+        if sugg_index > 0:
+            if sugg_index - 1 < len(suggestions):
+                self.add("word_accepted", suggestions[sugg_index - 1])
+            return
+        char = self._alphabet[cursor % len(self._alphabet)]
+        if char.isalpha():
+            self.add("letter_typed", char)
+        elif char == "_":
+            self.add("space", "")
+        elif char == "<":
+            self.add("backspace", "")
+        elif char == "]":
+            self.add("sentence_cleared", "")
+
+    def _on_accept_top(self, before):
+        if before[3]:
+            self.add("word_accepted", before[3][0])
+
+    def _on_send(self, before):
+        spoken = self._state.tts.spoken
+        if spoken and len(spoken) > self.counts.get("message_sent", 0):
+            self.add("message_sent", spoken[-1])
+
+
+# ── Simulation ───────────────────────────────────────────────────────────────
+
+def simulate(recording: str, *, sensor: Path, mode: str | None, render: bool) -> dict:
+    install_stubs()
+    os.chdir(APP_DIR)          # the predictor loads data/ relative to here
+
+    import app_state
+    import input_processor
+
+    stages = {name: Stage(name) for name in ("sensor", "update", "render", "show")}
+    frames = run_sensor(sensor, recording, stages["sensor"])
+    if not frames:
+        raise SystemExit("Recording produced no frames")
+
+    clock = VirtualClock(frames[0][0])
+    app_state.time = clock
+    input_processor.time = clock
+
+    t_load = time.perf_counter_ns()
+    state = app_state.AppState()
+    load_s = (time.perf_counter_ns() - t_load) / 1e9
+    if mode:
+        state.mode = mode
+    actions = ActionLog(state, clock, frames[0][0])
+
+    oled = None
+    if render:
+        from oled_driver import ImageOps, OLEDBuffer
+        oled = OLEDBuffer()
+
+    wall0 = time.perf_counter_ns()
+    i, n, prev_mode = 0, len(frames), state.mode
+    while i < n:
+        # read_latest(): everything that arrived since the last pass, newest wins
+        latest = None
+        while i < n and frames[i][0] <= clock.now:
+            latest = frames[i]
+            i += 1
+
+        if latest is not None:
+            t = time.perf_counter_ns()
+            state.update(latest[1], latest[2])
+            stages["update"].add(time.perf_counter_ns() - t)
+
+            if state.mode != prev_mode:
+                actions.add("mode_switch", state.mode)
+                prev_mode = state.mode
+            if state.restart_requested:
+                state.restart_requested = False
+                actions.add("recalibration_requested", "")
+
+            if oled is not None:
+                t = time.perf_counter_ns()
+                oled.clear()
+                if state.mode == app_state.MODE_WRITE:
+                    oled.draw_write_scene(
+                        sentence=state.sentence, prefix=state.prefix,
+                        cursor_index=state.cursor_index, sugg_index=state.sugg_index,
+                        suggestions=state.suggestions, dwell_percent=state.dwell_percent,
+                        direction=state.input.direction,
+                    )
+                else:
+                    oled.draw_caption_scene(
+                        transcript=state.captioner.transcript,
+                        scroll_offset=state.transcript_scroll,
+                        paused=state.captioner.paused,
+                        direction=state.input.direction,
+                        dwell_percent=state.dwell_percent,
+                    )
+                t1 = time.perf_counter_ns()
+                stages["render"].add(t1 - t)
+                # Host half of SSD1309Driver.show(); the SPI transfer is not simulated
+                ImageOps.mirror(oled.image).tobytes()
+                stages["show"].add(time.perf_counter_ns() - t1)
+
+        clock.sleep(LOOP_DELAY_S)
+    wall_s = (time.perf_counter_ns() - wall0) / 1e9 + stages["sensor"].ns / 1e9
+
+    session_s = frames[-1][0] - frames[0][0]
+    return {
+        "recording": recording,
+        "frames": n,
+        "session_seconds": session_s,
+        "wall_seconds": wall_s,
+        "speedup": session_s / wall_s if wall_s else 0.0,
+        "app_load_seconds": load_s,
+        "final_mode": state.mode,
+        "final_text": (state.sentence + state.prefix).strip(),
+        "actions": actions.counts,
+        "stages": {name: s.report() for name, s in stages.items() if s.ops},
+        "events": actions.events,
+    }
+
+
+def _print_report(r: dict, show_events: bool):
+    print(f"{r['recording']}: {r['frames']} frames, {r['session_seconds']:.1f} s of session "
+          f"in {r['wall_seconds']:.2f} s ({r['speedup']:.0f}x real time)")
+    print(f"  app start-up {r['app_load_seconds']:.2f} s (not included)")
+    print("  stage       ops      us/op        ops/s")
+    for name, s in r["stages"].items():
+        print(f"  {name:<8} {s['ops']:>7} {s['us_per_op']:>10.1f} {s['ops_per_s']:>12.0f}")
+    print("  actions: " + (", ".join(f"{k}={v}" for k, v in sorted(r["actions"].items())) or "none"))
+    if r["final_text"]:
+        print(f"  text left on screen: {r['final_text']!r}")
+    if show_events:
+        for t, action, detail in r["events"]:
+            print(f"  {t:9.2f} s  {action:<24} {detail}")
+
+
+def main():
+    from serial_reader import SENSOR_BINARY
+
+    ap = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    ap.add_argument("recording", help="file written by sensor --record")
+    ap.add_argument("--mode", choices=("write", "caption"),
+                    help="start in this mode (the app starts in caption mode)")
+    ap.add_argument("--no-render", action="store_true", help="skip the OLED renderer")
+    ap.add_argument("--events", action="store_true", help="list every action with its time")
+    ap.add_argument("--json", metavar="OUT", help="also write the report as JSON")
+    ap.add_argument("--sensor", type=Path, default=SENSOR_BINARY, help="sensor binary")
+    args = ap.parse_args()
+
+    json_path = args.json and os.path.abspath(args.json)
+    result = simulate(os.path.abspath(args.recording), sensor=args.sensor.resolve(),
+                      mode=args.mode and args.mode.upper(), render=not args.no_render)
+    _print_report(result, args.events)
+    if json_path:
+        with open(json_path, "w") as f:
+            json.dump(result, f, indent=2)
+
+
+if __name__ == "__main__":
+    main()
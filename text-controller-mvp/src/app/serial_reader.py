@@ -1,38 +1,113 @@
-"""Reads roll,pitch lines from the local sensor binary via subprocess."""
+"""Reads roll,pitch lines from the local sensor binary via subprocess.
+
+The binary announces its output schema with a ``#HELLO`` meta frame before
+the first sample (see ``sensor/protocol.h``). Data lines are parsed by field
+name from that schema, so new fields can be added on the sensor side without
+breaking this reader.
+
+On SIGTERM the binary finishes the current sample, saves its calibration,
+drains its output and ends with ``#BYE``. A restart with ``warm=True`` then
+reuses that calibration instead of recalibrating from scratch.
+
+Each frame also carries its trace id and sensor-side timestamps; the frame
+returned by read_latest() is described by ``trace`` (see ``latency.py``).
+"""
 
 import subprocess
 import threading
+import time
+from collections import deque
 from pathlib import Path
 
+from latency import FrameTrace
+
 SENSOR_BINARY = Path(__file__).parent.parent / "sensor" / "sensor"
 
+# Fields requested from the binary; only these are formatted on its side
+SENSOR_FIELDS = ("roll", "pitch", "seq", "t_us", "tx_us")
+
+# Schema assumed for binaries that predate the #HELLO handshake
+LEGACY_FIELDS = ("roll", "pitch")
+
+# Silence longer than this many #HEALTH periods means the binary is hung
+HEALTH_MISSED_PERIODS = 3
+DEFAULT_HEALTH_MS     = 1000
+STARTUP_GRACE_SEC     = 5.0    # calibration emits no frames for ~2 s
+STDERR_TAIL_LINES     = 20
+STOP_TIMEOUT_SEC      = 2.0    # SIGTERM grace before SIGKILL
+EXIT_STALLED          = 3      # sensor watchdog gave up on a hung I2C read
+SENSOR_CPU_MS         = 10000  # #CPU period, read by CpuBudget
+
+
+def _parse_meta(line: str) -> tuple[str, dict[str, str]]:
+    """Split '#TYPE k=v k=v' into ('TYPE', {k: v})."""
+    parts = line[1:].split()
+    if not parts:
+        return "", {}
+    info = {}
+    for tok in parts[1:]:
+        key, sep, value = tok.partition("=")
+        if sep:
+            info[key] = value
+    return parts[0], info
+
 
 class SerialReader:
     def __init__(self, _port=None, _baud=None):
         # _port and _baud are ignored — kept for API compatibility
         self._proc   = None
         self._latest = None
+        self._latest_trace = None
         self._lock   = threading.Lock()
         self._thread = None
         self.last_error = ""
 
-    def restart(self):
-        """Kill and respawn the sensor subprocess."""
-        if self._proc:
-            self._proc.terminate()
-            self._proc.wait()
-            self._proc = None
-        self.connect()
+        # Filled in from the #HELLO handshake
+        self.protocol: dict[str, str] = {}
+        self.fields: tuple[str, ...] = LEGACY_FIELDS
+        self.last_frame: dict[str, float] = {}
+        self.trace: FrameTrace | None = None    # stamps of the last read_latest() frame
+        self.calibration = ""               # "fresh" or "warm", from #READY
+        self.config: dict[str, str] = {}    # sensor tunables, from #CONFIG
+        self.last_bye: dict[str, str] = {}
+        self.last_stall: dict[str, str] = {}  # latest #STALL from the watchdog
+        self.last_cpu: dict[str, str] = {}    # latest #CPU, cumulative per thread
+        # Called on the reader thread with the dump path after a TRACE
+        # command, or None if the sensor could not dump
+        self.on_trace_dump = None
+
+        # Liveness tracking, see check_health()
+        self.last_health: dict[str, float] = {}
+        self._prev_health: dict[str, float] = {}
+        # stage -> (p50, p99, p999) us, from #TIMING after each #HEALTH
+        self.last_timing: dict[str, tuple[float, ...]] = {}
+        self._started_at = 0.0
+        self._last_line_at = 0.0
+        self.stderr_tail: deque[str] = deque(maxlen=STDERR_TAIL_LINES)
+
+    def restart(self, warm: bool = False):
+        """Stop and respawn the sensor subprocess.
+
+        With warm=True the new process reuses the calibration the old one
+        saved on shutdown, if it is recent enough.
+        """
+        self._stop()
+        self.connect(warm)
 
-    def connect(self) -> bool:
+    def connect(self, warm: bool = False) -> bool:
         if not SENSOR_BINARY.exists():
             self.last_error = f"Sensor binary not found: {SENSOR_BINARY}"
             return False
+        args = [str(SENSOR_BINARY), "--fields", ",".join(SENSOR_FIELDS),
+                "--cpu-ms", str(SENSOR_CPU_MS)]
+        if warm:
+            args.append("--warm-start")
         try:
             self._proc = subprocess.Popen(
-                [str(SENSOR_BINARY)],
+                args,
+                stdin=subprocess.PIPE,       # control channel
                 stdout=subprocess.PIPE,
-                stderr=subprocess.DEVNULL,   # suppress calibration prints
+                stderr=subprocess.PIPE,      # kept for diagnostics
                 text=True,
                 bufsize=1,                   # line-buffered
             )
@@ -40,29 +115,153 @@ class SerialReader:
             self.last_error = str(e)
             return False
 
-        self._thread = threading.Thread(target=self._read_loop, daemon=True)
+        self._started_at = self._last_line_at = time.time()
+        self.last_health = {}
+        self._prev_health = {}
+        self._thread = threading.Thread(target=self._read_loop, name="sensor-reader", daemon=True)
         self._thread.start()
+        threading.Thread(target=self._stderr_loop, args=(self._proc,), name="sensor-stderr",
+                         daemon=True).start()
         return True
 
     def _read_loop(self):
+        self.protocol = {}
+        self.fields = LEGACY_FIELDS
+        self.calibration = ""
         for line in self._proc.stdout:
             line = line.strip()
             if not line:
                 continue
+            self._last_line_at = time.time()
+            received_ns = time.monotonic_ns()
+            if line.startswith("#"):
+                self._handle_meta(line)
+                continue
             try:
-                roll, pitch = map(float, line.split(","))
+                values = line.split(",")
+                if len(values) != len(self.fields):
+                    continue
+                frame = dict(zip(self.fields, map(float, values)))
+                trace = self._trace(frame, received_ns)
                 with self._lock:
-                    self._latest = (roll, pitch)
+                    self.last_frame = frame
+                    self._latest = (frame["roll"], frame["pitch"])
+                    self._latest_trace = trace
+            except (ValueError, KeyError):
+                pass
+
+    def _trace(self, frame: dict[str, float], received_ns: int) -> FrameTrace | None:
+        if "seq" not in frame:
+            return None
+        # Replayed timestamps come from the recording, not this boot's clock
+        same_clock = "tx_us" in frame and self.protocol.get("source") != "replay"
+        return FrameTrace(
+            seq=int(frame["seq"]),
+            acquired_ns=int(frame["t_us"]) * 1000 if same_clock and "t_us" in frame else None,
+            formatted_ns=int(frame["tx_us"]) * 1000 if same_clock else None,
+            received_ns=received_ns,
+        )
+
+    def _handle_meta(self, line: str):
+        kind, info = _parse_meta(line)
+        if kind == "HELLO":
+            self.protocol = info
+            fields = info.get("fields", "")
+            self.fields = tuple(fields.split(",")) if fields else LEGACY_FIELDS
+        elif kind == "HEALTH":
+            try:
+                health = {k: float(v) for k, v in info.items()}
+            except ValueError:
+                return
+            self._prev_health, self.last_health = self.last_health, health
+        elif kind == "TIMING":
+            try:
+                self.last_timing = {k: tuple(float(x) for x in v.split("/"))
+                                    for k, v in info.items() if k != "overruns"}
             except ValueError:
                 pass
+        elif kind == "CONFIG":
+            self.config = info              # re-sent after every reload
+        elif kind == "STALL":
+            self.last_stall = info
+        elif kind == "CPU":
+            self.last_cpu = info
+        elif kind == "READY":
+            self.calibration = info.get("calibration", "")
+        elif kind == "BYE":
+            self.last_bye = info
+        elif kind == "TRACE" or (kind == "ERROR" and info.get("cmd") == "TRACE"):
+            if self.on_trace_dump:
+                self.on_trace_dump(info.get("path"))
+
+    def send_command(self, command: str) -> bool:
+        """Send one control command (e.g. "HEALTH", "FIELDS roll,pitch,t_us")."""
+        if self._proc is None or self._proc.stdin is None:
+            return False
+        try:
+            self._proc.stdin.write(command.strip() + "\n")
+            self._proc.stdin.flush()
+            return True
+        except (BrokenPipeError, ValueError):
+            return False
+
+    def _stderr_loop(self, proc):
+        for line in proc.stderr:
+            line = line.rstrip()
+            if line:
+                self.stderr_tail.append(line)
+
+    def check_health(self) -> str:
+        """Return "" while the sensor looks alive, else a short reason.
+
+        A still head keeps producing frames and #HEALTH; a hung process or
+        stalled bus goes quiet, or reports I2C errors with no new samples.
+        """
+        if self._proc is None:
+            return "not running"
+        rc = self._proc.poll()
+        if rc == EXIT_STALLED:
+            return "acquisition stalled (watchdog exit)"
+        if rc is not None:
+            tail = self.stderr_tail[-1] if self.stderr_tail else ""
+            return f"exited with status {rc}" + (f": {tail}" if tail else "")
+
+        now = time.time()
+        if now - self._started_at < STARTUP_GRACE_SEC:
+            return ""
+
+        health_ms = float(self.protocol.get("health_ms", DEFAULT_HEALTH_MS)) or DEFAULT_HEALTH_MS
+        timeout = HEALTH_MISSED_PERIODS * health_ms / 1000.0
+        silent = now - self._last_line_at
+        if silent > timeout:
+            return f"no output for {silent:.1f} s"
+
+        cur, prev = self.last_health, self._prev_health
+        if cur and prev:
+            if cur.get("samples") == prev.get("samples") and \
+                    cur.get("i2c_errors", 0) > prev.get("i2c_errors", 0):
+                return f"I2C errors ({int(cur['i2c_errors'])}) and no samples"
+        return ""
 
     def read_latest(self):
         with self._lock:
             val = self._latest
+            if val is not None:
+                self.trace = self._latest_trace
             self._latest = None
             return val
 
-    def close(self):
-        if self._proc:
-            self._proc.terminate()
+    def _stop(self):
+        """SIGTERM, then SIGKILL if the binary misses its shutdown budget."""
+        if self._proc is None:
+            return
+        self._proc.terminate()
+        try:
+            self._proc.wait(timeout=STOP_TIMEOUT_SEC)
+        except subprocess.TimeoutExpired:
+            self._proc.kill()
             self._proc.wait()
+        self._proc = None
+
+    def close(self):
+        self._stop()
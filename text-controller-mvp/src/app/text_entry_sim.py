@@ -0,0 +1,395 @@
+"""Offline text-entry simulator: keystrokes per character and words per minute.
+
+    python3 text_entry_sim.py PHRASES.txt [--user optimal|stochastic]
+                              [--set NAME=V1,V2,...]... [--seeds N]
+                              [--phrases N] [--jobs N] [--json OUT]
+
+A modelled user types each phrase of the corpus (one per line) into a
+real AppState, then sends it with SE. The same virtual clock as
+replay_sim.py drives the app, so dwell, cooldown and deadzone timing is
+the app's own. The user works in a closed loop. Each time the screen
+changes they react after ``reaction_s`` and pick the next move:
+
+  - accept the wanted word when it is among the suggestions
+    (NE for the top one, S then a centre dwell for the others);
+  - otherwise scroll the alphabet ring the short way round and dwell
+    at the centre on the next letter (``_`` ends a word);
+  - drop a wrong prefix or word with SW.
+
+Head movement follows a first-order lag that covers 95 % of a move in
+``move_s``. The stochastic user adds a per-move aim error, sensor noise
+and reaction-time spread, so overshoots and misfires happen as they
+would live. A user who sees the wrong direction on screen once a move
+has settled aims again.
+
+Every ``--set`` takes a list of values and the grid is their cross
+product. Each grid point runs ``--seeds`` times on ``--jobs`` worker
+processes. Tunables are the timing constants in app_state.py, the
+deadzones in input_processor.py, ``predict`` (0 turns suggestions off)
+and the user-model parameters below.
+
+Reported per grid point:
+  KSPC      keystrokes per character. Every scroll step, centre
+            selection and diagonal action counts, except the final send.
+  sel/word  centre selections plus NE accepts per word.
+  pred      share of words finished by accepting a suggestion.
+  WPM       (len(phrase) - 1) / 5 characters per minute, timed from the
+            previous send to this one.
+"""
+
+import argparse
+import itertools
+import json
+import math
+import multiprocessing
+import os
+import random
+import sys
+import time
+
+from replay_sim import APP_DIR, LOOP_DELAY_S, VirtualClock, install_stubs
+
+USER_MODELS = {
+    # Reacts instantly, aims exactly, no tremor: the ceiling for a setting
+    "optimal": dict(reaction_s=0.0, reaction_sd=0.0, move_s=0.15, tilt=0.25,
+                    noise=0.0, aim_sd=0.0),
+    "stochastic": dict(reaction_s=0.35, reaction_sd=0.1, move_s=0.25, tilt=0.25,
+                       noise=0.01, aim_sd=8.0),
+}
+
+APP_TUNABLES   = ("DWELL_CENTER_SEC", "DWELL_DIAGONAL_SEC", "SCROLL_COOLDOWN_SEC",
+                  "CENTER_RETURN_COOLDOWN_SEC", "CENTER_REFIRE_COOLDOWN_SEC")
+INPUT_TUNABLES = ("DEADZONE_RADIUS", "DEAD_BAND_DEG")
+
+# A phrase not sent within this much simulated time counts as a timeout
+PHRASE_TIMEOUT_S = 600.0
+
+# Angle of each direction, as input_processor reads it back
+_ANGLES = {"E": 0, "NE": 45, "N": 90, "NW": 135, "W": 180, "SW": 225, "S": 270, "SE": 315}
+
+
+# ── Corpus ───────────────────────────────────────────────────────────────────
+
+def load_phrases(path: str, alphabet: str, limit: int | None) -> list[str]:
+    """Upper-cased phrases holding only characters the alphabet ring can type."""
+    letters = set(alphabet) - set("_<[].")
+    phrases = []
+    with open(path, encoding="utf-8") as f:
+        for line in f:
+            words = ["".join(c for c in w if c in letters) for w in line.upper().split()]
+            phrase = " ".join(w for w in words if w)
+            if phrase:
+                phrases.append(phrase)
+            if limit and len(phrases) >= limit:
+                break
+    return phrases
+
+
+# ── Predictor wrappers ───────────────────────────────────────────────────────
+
+class _CachedPredictor:
+    """Suggestions depend only on (prefix, sentence); the app asks every frame."""
+
+    def __init__(self, predictor):
+        self._predictor = predictor
+        self._cache: dict = {}
+
+    def get_suggestions(self, current_input: str, context: str = "", max_results: int = 3):
+        key = (current_input, context, max_results)
+        hit = self._cache.get(key)
+        if hit is None:
+            hit = self._cache[key] = self._predictor.get_suggestions(
+                current_input, context=context, max_results=max_results)
+        return list(hit[0]), hit[1], hit[2]
+
+
+class _NoPredictor:
+    def get_suggestions(self, current_input: str, context: str = "", max_results: int = 3):
+        return [], "—", ""
+
+
+# ── User model ───────────────────────────────────────────────────────────────
+
+class Typist:
+    """Closed-loop head-tilt user aiming for one phrase at a time."""
+
+    def __init__(self, p: dict, rng: random.Random, alphabet: str):
+        self.p = p
+        self.rng = rng
+        self.alphabet = alphabet
+        self.intent = "CENTER"
+        self.roll = self.pitch = 0.0
+        self._target = (0.0, 0.0)
+        self._aimed_at = 0.0
+        self._alpha = 1.0 - pow(0.05, LOOP_DELAY_S / p["move_s"]) if p["move_s"] > 0 else 1.0
+
+    def plan(self, s, phrase: str) -> str:
+        """The direction to hold next, given what the screen shows."""
+        want = self._plan(s, phrase)
+        # A diagonal fires once per visit: leave it before using it again
+        return "CENTER" if want == s._diagonal_fired else want
+
+    def _plan(self, s, phrase: str) -> str:
+        if s.mode != "WRITE":
+            return "NW"
+        typed = s.sentence + s.prefix
+        done = phrase + " "
+        if typed in (phrase, done):
+            return "SE"
+        if not done.startswith(typed):
+            return "SW"
+
+        if s.sentence and not s.sentence.endswith(" "):
+            char = "_"                  # a backspace ate the word's space
+        else:
+            words = phrase.split(" ")
+            word = words[len(s.sentence.split())]
+            if word in s.suggestions:
+                slot = s.suggestions.index(word) + 1
+                if slot == 1 and s.sugg_index == 0:
+                    return "NE"
+                return self._toward(s.sugg_index, slot, "S", "N")
+            if s.sugg_index:
+                return "N"
+            rest = word[len(s.prefix):]
+            char = rest[0] if rest else "_"
+
+        n = len(self.alphabet)
+        ahead = (self.alphabet.index(char) - s.cursor_index) % n
+        if ahead == 0:
+            return "CENTER"
+        return "E" if ahead <= n // 2 else "W"
+
+    @staticmethod
+    def _toward(current: int, wanted: int, up: str, down: str) -> str:
+        if current < wanted:
+            return up
+        return down if current > wanted else "CENTER"
+
+    def correct(self, shown: str, now: float):
+        """Re-aim when the screen shows a miss once the last move has settled."""
+        if shown != self.intent and now - self._aimed_at >= self.p["move_s"] + self.p["reaction_s"]:
+            self.aim(self.intent, now)
+
+    def aim(self, direction: str, now: float):
+        self.intent = direction
+        self._aimed_at = now
+        if direction == "CENTER":
+            self._target = (0.0, 0.0)
+            return
+        a = math.radians(_ANGLES[direction] + self.rng.gauss(0.0, self.p["aim_sd"]))
+        # input_processor: angle = atan2(pitch, -roll), so east is negative roll
+        self._target = (-self.p["tilt"] * math.cos(a), self.p["tilt"] * math.sin(a))
+
+    def step(self) -> tuple[float, float]:
+        self.roll  += (self._target[0] - self.roll) * self._alpha
+        self.pitch += (self._target[1] - self.pitch) * self._alpha
+        sd = self.p["noise"]
+        if sd:
+            return self.roll + self.rng.gauss(0.0, sd), self.pitch + self.rng.gauss(0.0, sd)
+        return self.roll, self.pitch
+
+    def reaction(self) -> float:
+        return max(0.0, self.rng.gauss(self.p["reaction_s"], self.p["reaction_sd"]))
+
+
+# ── Worker ───────────────────────────────────────────────────────────────────
+
+_w: dict = {}   # per-process modules, predictor and defaults
+
+
+def _init_worker(phrases: list[str]):
+    install_stubs()
+    os.chdir(APP_DIR)
+    sys.path.insert(0, str(APP_DIR))
+    import app_state
+    import input_processor
+    from predictor import PredictiveText
+
+    _w.update(
+        app=app_state, input=input_processor, phrases=phrases,
+        predictor=_CachedPredictor(PredictiveText()),
+        defaults={**{k: getattr(app_state, k) for k in APP_TUNABLES},
+                  **{k: getattr(input_processor, k) for k in INPUT_TUNABLES}},
+    )
+
+
+def _apply(settings: dict) -> dict:
+    """Set the app's constants for one grid point; returns the user model."""
+    app, inp = _w["app"], _w["input"]
+    for k in APP_TUNABLES:
+        setattr(app, k, settings.get(k, _w["defaults"][k]))
+    for k in INPUT_TUNABLES:
+        setattr(inp, k, settings.get(k, _w["defaults"][k]))
+    predictor = _w["predictor"] if settings.get("predict", 1) else _NoPredictor()
+    app.PredictiveText = lambda: predictor
+    return {k: settings.get(k, v) for k, v in USER_MODELS[settings["user"]].items()}
+
+
+def run_point(task: tuple[int, dict, int]) -> tuple[int, dict]:
+    """Type the whole corpus once at one grid point with one seed."""
+    index, settings, seed = task
+    app = _w["app"]
+    user = _apply(settings)
+
+    clock = VirtualClock(1000.0)
+    app.time = clock
+    _w["input"].time = clock
+    state = app.AppState()
+    state.mode = app.MODE_WRITE
+    typist = Typist(user, random.Random(seed), app.ALPHABET)
+
+    # Centre selections, and how many of them picked a suggestion
+    picks = {"select": 0, "suggestion": 0}
+    select_current = state._select_current
+
+    def counted_select():
+        picks["select"] += 1
+        picks["suggestion"] += state.sugg_index > 0
+        select_current()
+    state._select_current = counted_select
+
+    totals = dict(phrases=0, chars=0, words=0, seconds=0.0, keystrokes=0, selections=0,
+                  predicted=0, corrections=0, errors=0, timeouts=0)
+    wall0 = time.perf_counter()
+    for phrase in _w["phrases"]:
+        start = clock.now
+        sent = len(state.tts.spoken)
+        keys = accepts = fixes = 0
+        picks.update(select=0, suggestion=0)
+        next_decision = start
+        seen = None
+        while len(state.tts.spoken) == sent and clock.now - start < PHRASE_TIMEOUT_S:
+            if clock.now >= next_decision:
+                want = typist.plan(state, phrase)
+                if want != typist.intent:
+                    typist.aim(want, clock.now)
+                else:
+                    typist.correct(state.input.direction, clock.now)
+
+            scroll_t = state._last_scroll_time
+            fired = state._diagonal_fired
+            state.update(*typist.step())
+            if state._last_scroll_time != scroll_t:
+                keys += 1
+            if state._diagonal_fired and not fired:
+                d = state._diagonal_fired
+                if d == "NE":
+                    accepts += 1
+                if d == "SW":
+                    fixes += 1
+                if d != "SE":
+                    keys += 1
+
+            view = (state.mode, state.sentence, state.prefix, state.cursor_index, state.sugg_index)
+            if view != seen:
+                seen = view
+                next_decision = clock.now + typist.reaction()
+            clock.sleep(LOOP_DELAY_S)
+
+        totals["phrases"] += 1
+        totals["chars"] += len(phrase)
+        totals["words"] += len(phrase.split())
+        totals["seconds"] += clock.now - start
+        totals["keystrokes"] += keys + picks["select"]
+        totals["selections"] += accepts + picks["select"]
+        totals["predicted"] += accepts + picks["suggestion"]
+        totals["corrections"] += fixes
+        if len(state.tts.spoken) == sent:
+            totals["timeouts"] += 1
+            state._send_message()       # start the next phrase from a clean screen
+        elif state.tts.spoken[-1] != phrase:
+            totals["errors"] += 1
+
+    totals["wall_seconds"] = time.perf_counter() - wall0
+    return index, totals
+
+
+# ── Sweep ────────────────────────────────────────────────────────────────────
+
+def _parse_sets(items: list[str]) -> dict[str, list[float]]:
+    known = set(APP_TUNABLES) | set(INPUT_TUNABLES) | set(USER_MODELS["optimal"]) | {"predict"}
+    grid = {}
+    for item in items:
+        name, _, values = item.partition("=")
+        if name not in known or not values:
+            raise SystemExit(f"--set {item}: expected NAME=V1,V2,... with NAME one of "
+                             + ", ".join(sorted(known)))
+        grid[name] = [float(v) for v in values.split(",")]
+    return grid
+
+
+def summarise(settings: dict, runs: list[dict]) -> dict:
+    t = {k: sum(r[k] for r in runs) for k in runs[0]}
+    minutes = t["seconds"] / 60.0
+    return {
+        "settings": settings,
+        "wpm": (t["chars"] - t["phrases"]) / 5.0 / minutes if minutes else 0.0,
+        "kspc": t["keystrokes"] / t["chars"] if t["chars"] else 0.0,
+        "selections_per_word": t["selections"] / t["words"] if t["words"] else 0.0,
+        "predicted_share": t["predicted"] / t["words"] if t["words"] else 0.0,
+        "corrections": t["corrections"],
+        "errors": t["errors"],
+        "timeouts": t["timeouts"],
+        "simulated_seconds": t["seconds"],
+        "wall_seconds": t["wall_seconds"],
+    }
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    ap.add_argument("corpus", help="target phrases, one per line")
+    ap.add_argument("--user", choices=tuple(USER_MODELS), default="optimal")
+    ap.add_argument("--set", action="append", default=[], metavar="NAME=V1,V2,...",
+                    help="sweep a tunable over these values (repeatable)")
+    ap.add_argument("--seeds", type=int, default=1, help="runs per grid point")
+    ap.add_argument("--phrases", type=int, help="use only the first N phrases")
+    ap.add_argument("--jobs", type=int, default=os.cpu_count(), help="worker processes")
+    ap.add_argument("--json", metavar="OUT", help="also write the results as JSON")
+    args = ap.parse_args()
+
+    from font import ALPHABET
+    phrases = load_phrases(args.corpus, ALPHABET, args.phrases)
+    if not phrases:
+        raise SystemExit(f"No typeable phrases in {args.corpus}")
+    json_path = args.json and os.path.abspath(args.json)
+
+    grid = _parse_sets(args.set)
+    points = [dict(zip(grid, values), user=args.user)
+              for values in itertools.product(*grid.values())]
+    tasks = [(i, p, seed) for i, p in enumerate(points) for seed in range(args.seeds)]
+
+    wall0 = time.perf_counter()
+    runs: list[list[dict]] = [[] for _ in points]
+    jobs = max(1, min(args.jobs or 1, len(tasks)))
+    if jobs == 1:
+        _init_worker(phrases)
+        for index, totals in map(run_point, tasks):
+            runs[index].append(totals)
+    else:
+        with multiprocessing.Pool(jobs, _init_worker, (phrases,)) as pool:
+            for index, totals in pool.imap_unordered(run_point, tasks):
+                runs[index].append(totals)
+    wall_s = time.perf_counter() - wall0
+
+    summary = [summarise(p, r) for p, r in zip(points, runs)]
+    simulated = sum(s["simulated_seconds"] for s in summary)
+    print(f"{len(phrases)} phrases x {len(points)} settings x {args.seeds} seeds "
+          f"({args.user} user): {simulated / 3600:.1f} h simulated in {wall_s:.1f} s "
+          f"on {jobs} processes")
+    names = list(grid)
+    print("  " + "".join(f"{n:>{max(len(n), 6)}} " for n in names)
+          + "   WPM   KSPC  sel/word  pred  fixes  errors  timeouts")
+    for s in summary:
+        print("  " + "".join(f"{s['settings'][n]:>{max(len(n), 6)}g} " for n in names)
+              + f"{s['wpm']:6.2f} {s['kspc']:6.2f} {s['selections_per_word']:9.2f} "
+              f"{s['predicted_share']:5.0%} {s['corrections']:6d} {s['errors']:7d} "
+              f"{s['timeouts']:9d}")
+    if json_path:
+        with open(json_path, "w") as f:
+            json.dump({"user": args.user, "phrases": len(phrases), "seeds": args.seeds,
+                       "results": summary}, f, indent=2)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,79 @@
+"""App-side timeline events, merged with the sensor's trace dump.
+
+The sensor binary keeps a flight recorder of its loop stages, output
+writes and watchdog events (``sensor/trace.h``). This module keeps the
+matching record for the app: frame updates, rendering, SPI transfers,
+speech-recognition chunks and TTS jobs. Both sides stamp CLOCK_MONOTONIC,
+so one dump shows them on a single timeline in ``chrome://tracing`` or
+ui.perfetto.dev.
+
+Recording is a ``deque.append`` of a tuple, which is atomic under the GIL,
+so any thread may call ``span``/``complete`` without a lock. The deque
+keeps only the most recent ``MAX_EVENTS``.
+
+To take a dump, send SIGUSR1 to the app. It asks the sensor for its
+trace, then ``dump()`` writes both to ``TIMELINE_PATH``.
+"""
+
+import json
+import os
+import subprocess
+import threading
+import time
+from collections import deque
+from contextlib import contextmanager
+
+MAX_EVENTS    = 16384
+TIMELINE_PATH = "/var/tmp/text-controller-timeline.json"
+
+# (name, native thread id, start ns, duration ns)
+_events: deque = deque(maxlen=MAX_EVENTS)
+
+
+def complete(name: str, start_ns: int, end_ns: int):
+    """Record a finished span on the calling thread."""
+    _events.append((name, threading.get_native_id(), start_ns, end_ns - start_ns))
+
+
+@contextmanager
+def span(name: str):
+    start = time.monotonic_ns()
+    try:
+        yield
+    finally:
+        complete(name, start, time.monotonic_ns())
+
+
+def load_sensor_trace(binary, dump_path: str) -> list[dict]:
+    """Chrome events from a sensor dump, via ``sensor --trace-json``."""
+    try:
+        out = subprocess.run([str(binary), "--trace-json", dump_path],
+                             capture_output=True, text=True, timeout=10, check=True)
+        return json.loads(out.stdout)["traceEvents"]
+    except (OSError, subprocess.SubprocessError, ValueError, KeyError) as e:
+        print(f"Sensor trace {dump_path} not converted: {e}")
+        return []
+
+
+def dump(path: str = TIMELINE_PATH, sensor_events: list[dict] | None = None) -> int:
+    """Write the app's events (plus the sensor's, if given) as Chrome JSON.
+
+    Returns the number of events written.
+    """
+    pid = os.getpid()
+    names = {t.native_id: t.name for t in threading.enumerate()}
+    events = list(sensor_events or [])
+    events.append({"name": "process_name", "ph": "M", "pid": pid, "args": {"name": "app"}})
+    snapshot = list(_events)
+    for tid in {e[1] for e in snapshot}:
+        events.append({"name": "thread_name", "ph": "M", "pid": pid, "tid": tid,
+                       "args": {"name": names.get(tid, str(tid))}})
+    for name, tid, start, dur in snapshot:
+        events.append({"name": name, "ph": "X", "pid": pid, "tid": tid,
+                       "ts": start / 1e3, "dur": dur / 1e3})
+
+    tmp = path + ".tmp"
+    with open(tmp, "w") as f:
+        json.dump({"displayTimeUnit": "ms", "traceEvents": events}, f)
+    os.replace(tmp, path)
+    return len(events)
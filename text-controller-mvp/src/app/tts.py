@@ -5,6 +5,8 @@ import threading
 import subprocess
 import logging
 
+import timeline
+
 log = logging.getLogger(__name__)
 
 # ── Configuration ──────────────────────────────────────────────────────────────
@@ -80,7 +82,7 @@ class TTSQueue:
     def __init__(self, model_path: str = MODEL_PATH):
         self._model  = model_path
         self._q      = queue.Queue()
-        self._thread = threading.Thread(target=self._worker, daemon=True)
+        self._thread = threading.Thread(target=self._worker, name="tts", daemon=True)
         self._thread.start()
         log.info("TTSQueue ready (Piper backend, model=%s)", model_path)
 
@@ -103,6 +105,7 @@ class TTSQueue:
             text = self._q.get()
             try:
                 log.debug("TTS speaking: %r", text)
-                _speak_now(text, model_path=self._model)
+                with timeline.span("tts_job"):
+                    _speak_now(text, model_path=self._model)
             except Exception as e:
                 log.error("TTS worker error: %s", e)
@@ -0,0 +1,231 @@
+// Benchmarks for the compiled n-gram model, without Python in the way.
+//
+//   make bench                         build, run on ../app/data/english.ngram
+//   ./predict_bench MODEL [--filter SUBSTR]
+//   ./predict_bench --synthetic N      N random 3..5-grams over 50k words
+//
+// Per order: context lookups that hit (every context in the table), that
+// miss (random id tuples) and that start from the words, the bits per
+// context the hash, fingerprints, starts and keys take, and the bytes per
+// n-gram with the successors and frequencies. Then whole suggest() calls
+// on contexts from the tables typed out prefix by prefix. Each result is
+// the median of several rounds. predict_check.py reports the Python
+// dicts' numbers; --synthetic shows how the tables scale past them.
+
+#include "compiler.h"
+#include "engine.h"
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <utility>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+constexpr int kRounds = 7;
+
+const char* g_filter = nullptr;
+
+uint64_t nowNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return uint64_t(ts.tv_sec) * 1'000'000'000ull + uint64_t(ts.tv_nsec);
+}
+
+// Keep the optimiser from discarding a value or hoisting a loop body
+template <typename T>
+inline void keep(const T& v) { asm volatile("" : : "r,m"(v) : "memory"); }
+
+template <typename Fn>
+void bench(const char* name, uint64_t ops, Fn fn) {
+    if (g_filter && !strstr(name, g_filter)) return;
+    if (!ops) return;
+
+    for (uint64_t i = 0; i < ops / 8 + 1; i++) fn(i);      // warm caches and branch predictors
+
+    double rounds[kRounds];
+    for (double& r : rounds) {
+        uint64_t t0 = nowNs();
+        for (uint64_t i = 0; i < ops; i++) fn(i);
+        r = static_cast<double>(nowNs() - t0) / ops;
+    }
+    for (int i = 1; i < kRounds; i++)
+        for (int j = i; j > 0 && rounds[j] < rounds[j - 1]; j--) {
+            double t = rounds[j]; rounds[j] = rounds[j - 1]; rounds[j - 1] = t;
+        }
+    fprintf(stderr, "  %-28s %10.1f ns/op %12.0f op/s\n", name, rounds[kRounds / 2],
+            1e9 / rounds[kRounds / 2]);
+}
+
+uint64_t g_rng = 0x9E3779B97F4A7C15ull;
+
+uint32_t rnd(uint32_t n) {
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 7;
+    g_rng ^= g_rng << 17;
+    return static_cast<uint32_t>(g_rng % n);
+}
+
+void benchOrder(const ngram::Model& model, int order) {
+    const ngram::OrderTable& t = model.header().orders[order];
+    const int k = order - 1;
+
+    std::vector<uint32_t> hits, misses;
+    uint32_t context[ngram::kMaxOrder];
+    std::vector<uint32_t> slots(t.context_count);
+    for (uint32_t s = 0; s < t.context_count; s++) slots[s] = s;
+    for (uint32_t s = t.context_count; s > 1; s--) std::swap(slots[s - 1], slots[rnd(s)]);
+    for (uint32_t s : slots) {     // in random order: slot order would walk memory
+        model.slotContext(order, s, context);
+        hits.insert(hits.end(), context, context + k);
+    }
+    for (size_t i = 0; i < hits.size() && model.vocabularySize(); i++)
+        misses.push_back(rnd(static_cast<uint32_t>(model.vocabularySize())));
+
+    const size_t mph   = size_t(t.bucket_count) * 2 + size_t(t.table_size - t.context_count) * 4;
+    const size_t table = mph + (size_t(t.context_count) + 1) * 8 + size_t(t.context_count) * t.key_words * 8;
+    const size_t lists = size_t(t.successor_count) * (4 + 8);
+    const double n     = t.context_count ? t.context_count : 1;
+    fprintf(stderr, "%d-grams: %u contexts (%u-bit ids, %u-word keys), bits per context: "
+            "%.2f hash + 16 fingerprint + 32 start + %u key; "
+            "%zu B table + %zu B lists = %.1f B per n-gram\n",
+            order, t.context_count, model.header().key_bits, t.key_words, mph * 8 / n, t.key_words * 64,
+            table, lists, t.successor_count ? double(table + lists) / t.successor_count : 0.0);
+
+    char name[64];
+    const uint64_t count = t.context_count;
+    snprintf(name, sizeof(name), "context.%dgram.hit", order);
+    bench(name, count, [&](uint64_t i) { keep(model.successors(order, &hits[(i % count) * k]).size); });
+    snprintf(name, sizeof(name), "context.%dgram.miss", order);
+    bench(name, count, [&](uint64_t i) { keep(model.successors(order, &misses[(i % count) * k]).size); });
+    // From the words, as suggest() starts: what a Python dict lookup does
+    snprintf(name, sizeof(name), "context.%dgram.words", order);
+    bench(name, count, [&](uint64_t i) {
+        const uint32_t* c = &hits[(i % count) * k];
+        uint32_t ids[ngram::kMaxOrder];
+        for (int w = 0; w < k; w++) ids[w] = model.findWord(model.word(c[w]), model.wordLength(c[w]));
+        keep(model.successors(order, ids).size);
+    });
+}
+
+// Contexts with the successor typed out one byte at a time, as the app asks
+struct Query {
+    const char* words[ngram::kMaxOrder - 1];
+    size_t      lens[ngram::kMaxOrder - 1];
+    size_t      nwords;
+    const char* prefix;
+    size_t      prefix_len;
+};
+
+std::vector<Query> queries(const ngram::Model& model) {
+    std::vector<Query> out;
+    for (int order = 2; order <= ngram::kMaxOrder; order++) {
+        const uint32_t contexts = model.header().orders[order].context_count;
+        uint32_t context[ngram::kMaxOrder];
+        for (uint32_t s = 0; s < contexts; s++) {
+            model.slotContext(order, s, context);
+            ngram::IdSpan next = model.successors(order, context);
+            Query q{};
+            q.nwords = static_cast<size_t>(order - 1);
+            for (size_t i = 0; i < q.nwords; i++) {
+                q.words[i] = model.word(context[i]);
+                q.lens[i]  = model.wordLength(context[i]);
+            }
+            q.prefix = model.word(next.ids[0]);
+            for (q.prefix_len = 0; q.prefix_len <= model.wordLength(next.ids[0]); q.prefix_len++)
+                out.push_back(q);
+        }
+    }
+    return out;
+}
+
+// A model of `rows` random 3..5-grams, a third per order, over 50k words
+// with Zipf-ish unigram counts and one bigram per word; nullptr on success
+const char* writeSynthetic(const char* path, uint64_t rows) {
+    constexpr uint32_t kWords = 50'000;
+    ngram::Compiler          compiler;
+    std::vector<std::string> words(kWords);
+    std::vector<size_t>      lens(kWords);
+    for (uint32_t i = 0; i < kWords; i++) {
+        words[i] = "w" + std::to_string(i);
+        lens[i]  = words[i].size();
+        compiler.addUnigram(words[i].data(), lens[i], 1'000'000 / (i + 1));
+    }
+    const char* row[ngram::kMaxOrder];
+    size_t      row_lens[ngram::kMaxOrder];
+    for (uint32_t i = 0; i < kWords; i++) {
+        const uint32_t next = (i + 1) % kWords;
+        row[0] = words[i].data();    row_lens[0] = lens[i];
+        row[1] = words[next].data(); row_lens[1] = lens[next];
+        compiler.addNgram(2, row, row_lens, 1);
+    }
+    for (uint64_t r = 0; r < rows; r++) {
+        const int order = 3 + static_cast<int>(r % 3);
+        for (int w = 0; w < order; w++) {
+            uint32_t id = rnd(kWords);
+            row[w]      = words[id].data();
+            row_lens[w] = lens[id];
+        }
+        compiler.addNgram(order, row, row_lens, 1);
+    }
+    return compiler.write(path);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* path      = nullptr;
+    uint64_t    synthetic = 0;
+    bool        usage     = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--filter") && i + 1 < argc)         g_filter  = argv[++i];
+        else if (!strcmp(argv[i], "--synthetic") && i + 1 < argc) synthetic = strtoull(argv[++i], nullptr, 10);
+        else if (argv[i][0] != '-' && !path)                     path      = argv[i];
+        else                                                     usage     = true;
+    }
+    if (usage || !path == !synthetic) {
+        fprintf(stderr, "Usage: %s MODEL | --synthetic N [--filter SUBSTR]\n", argv[0]);
+        return 2;
+    }
+
+    std::string temp;
+    if (synthetic) {
+        const char* dir = getenv("TMPDIR");
+        temp = std::string(dir && *dir ? dir : "/tmp") + "/predict_bench." + std::to_string(getpid()) + ".ngram";
+        path = temp.c_str();
+        uint64_t t0 = nowNs();
+        if (const char* error = writeSynthetic(path, synthetic)) {
+            fprintf(stderr, "Writing %s: %s\n", path, error);
+            return 1;
+        }
+        fprintf(stderr, "compiled %llu synthetic n-grams in %.0f ms\n",
+                static_cast<unsigned long long>(synthetic), (nowNs() - t0) / 1e6);
+    }
+
+    ngram::Engine engine;
+    const char*   error = engine.open(path);
+    if (!temp.empty()) unlink(path);       // the mapping outlives the name
+    if (error) {
+        fprintf(stderr, "Model %s %s\n", path, error);
+        return 1;
+    }
+    const ngram::Model& model = engine.model();
+    fprintf(stderr, "%s: format v%u, %zu words, %llu bytes\n", path, model.header().version,
+            model.vocabularySize(), static_cast<unsigned long long>(model.header().file_size));
+
+    for (int order = 2; order <= ngram::kMaxOrder; order++) benchOrder(model, order);
+
+    std::vector<Query> qs = queries(model);
+    ngram::Suggestions result;
+    result.words.reserve(16);
+    bench("suggest.typed", qs.size(), [&](uint64_t i) {
+        const Query& q = qs[i % qs.size()];
+        engine.suggest(q.prefix, q.prefix_len, q.words, q.lens, q.nwords, 3, result);
+        keep(result.level);
+    });
+    return 0;
+}
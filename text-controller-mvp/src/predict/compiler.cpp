@@ -0,0 +1,352 @@
+#include "compiler.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+#include <unistd.h>
+
+namespace ngram {
+
+namespace {
+
+// Append `count` elements at the next 8-byte boundary, returning their offset
+template <typename T>
+uint64_t appendSection(std::vector<uint8_t>& out, const T* data, size_t count) {
+    out.resize((out.size() + 7) & ~size_t(7), 0);
+    uint64_t offset = out.size();
+    if (count) {
+        out.resize(out.size() + count * sizeof(T));
+        memcpy(out.data() + offset, data, count * sizeof(T));
+    }
+    return offset;
+}
+
+// PTHash over the packed keys: sets the table's MPH fields, fills the
+// pilots and remap, and returns each context's slot. Buckets go largest
+// first, each taking the first pilot that sends all of its keys to free,
+// distinct positions; a bucket no pilot fits (or two keys hashing alike)
+// starts over under another seed.
+std::vector<uint32_t> buildMph(OrderTable& t, const std::vector<uint64_t>& keys,
+                               std::vector<uint16_t>& pilots, std::vector<uint32_t>& remap) {
+    const uint32_t n  = t.context_count;
+    const uint32_t kw = t.key_words;
+    t.bucket_count = (n + kBucketSize - 1) / kBucketSize;
+    t.table_size   = n ? n + n / 64 + 1 : 0;
+    pilots.assign(t.bucket_count, 0);
+    remap.assign(t.table_size - n, 0);
+    std::vector<uint32_t> slot(n);
+    if (!n) return slot;
+
+    const uint32_t        buckets = t.bucket_count, m = t.table_size;
+    std::vector<uint64_t> hashes(n);
+    std::vector<uint32_t> first(buckets + 1), members(n), order(buckets);
+    std::vector<uint8_t>  taken(m);
+    for (uint64_t seed = 0x6E6772616D5EEDull; ; seed = mix64(seed + 1)) {
+        t.seed = seed;
+        for (uint32_t c = 0; c < n; c++) hashes[c] = hashKey(&keys[size_t(c) * kw], kw, seed);
+
+        // Keys grouped by bucket, buckets by size
+        std::fill(first.begin(), first.end(), 0);
+        for (uint32_t c = 0; c < n; c++) first[mphBucket(hashes[c], buckets) + 1]++;
+        for (uint32_t b = 0; b < buckets; b++) first[b + 1] += first[b];
+        std::vector<uint32_t> fill(first.begin(), first.end() - 1);
+        for (uint32_t c = 0; c < n; c++) members[fill[mphBucket(hashes[c], buckets)]++] = c;
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&first](uint32_t a, uint32_t b) {
+            return first[a + 1] - first[a] > first[b + 1] - first[b];
+        });
+
+        std::fill(taken.begin(), taken.end(), 0);
+        bool     placed = true;
+        uint32_t pos[64];
+        for (uint32_t b : order) {
+            const uint32_t* in   = &members[first[b]];
+            const uint32_t  size = first[b + 1] - first[b];
+            if (!size) break;                   // and so are the rest
+            if (size > 64) {
+                placed = false;
+                break;
+            }
+            uint32_t pilot = 0;
+            for (; pilot <= kMaxPilot; pilot++) {
+                uint32_t j = 0;
+                for (; j < size; j++) {
+                    pos[j] = mphPosition(hashes[in[j]], pilot, m);
+                    if (taken[pos[j]] || std::find(pos, pos + j, pos[j]) != pos + j) break;
+                }
+                if (j == size) break;
+            }
+            if (pilot > kMaxPilot) {
+                placed = false;
+                break;
+            }
+            pilots[b] = static_cast<uint16_t>(pilot);
+            for (uint32_t j = 0; j < size; j++) {
+                taken[pos[j]] = 1;
+                slot[in[j]]   = pos[j];
+            }
+        }
+        if (placed) break;
+        std::fill(pilots.begin(), pilots.end(), 0);
+    }
+
+    // Positions past n move into the holes below it, in order
+    uint32_t hole = 0;
+    for (uint32_t p = n; p < t.table_size; p++) {
+        if (!taken[p]) continue;
+        while (taken[hole]) hole++;
+        remap[p - n] = hole++;
+    }
+    for (uint32_t& s : slot)
+        if (s >= n) s = remap[s - n];
+    return slot;
+}
+
+} // namespace
+
+// ── Building ───────────────────────────────────────────────────────────────
+
+bool Compiler::intern(const char* word, size_t len, uint32_t& id) {
+    if (len == 0 || memchr(word, '\0', len)) return false;
+    std::string w(word, len);
+    auto it = _ids.find(w);
+    if (it != _ids.end()) {
+        id = it->second;
+        return true;
+    }
+    id = static_cast<uint32_t>(_words.size());
+    _words.push_back(w);
+    _ids.emplace(std::move(w), id);
+    return true;
+}
+
+bool Compiler::addUnigram(const char* word, size_t len, uint64_t freq) {
+    uint32_t id;
+    if (!intern(word, len, id)) return false;
+    _unigrams.push_back(id);
+    _unigram_freqs.push_back(freq);
+    return true;
+}
+
+bool Compiler::addNgram(int order, const char* const* words, const size_t* lens, uint64_t freq) {
+    Row row{};
+    for (int i = 0; i < order; i++)
+        if (!intern(words[i], lens[i], row.words[i])) return false;
+    row.freq = freq;
+    _rows[order].push_back(row);
+    return true;
+}
+
+// ── Writing ────────────────────────────────────────────────────────────────
+
+const char* Compiler::write(const char* path) const {
+    // Ids become ranks in byte order
+    std::vector<uint32_t> sorted(_words.size());
+    std::iota(sorted.begin(), sorted.end(), 0);
+    std::sort(sorted.begin(), sorted.end(),
+              [this](uint32_t a, uint32_t b) { return _words[a] < _words[b]; });
+    std::vector<uint32_t> rank(_words.size());
+    for (uint32_t r = 0; r < sorted.size(); r++) rank[sorted[r]] = r;
+
+    FileHeader h{};
+    memcpy(h.magic, kFileMagic, sizeof(kFileMagic));
+    h.version       = kFormatVersion;
+    h.header_size   = sizeof(FileHeader);
+    h.vocab_size    = static_cast<uint32_t>(_words.size());
+    h.unigram_count = static_cast<uint32_t>(_unigrams.size());
+
+    std::vector<uint8_t> out(sizeof(FileHeader));
+
+    std::vector<uint32_t> offsets;
+    std::string           arena;
+    for (uint32_t id : sorted) {
+        offsets.push_back(static_cast<uint32_t>(arena.size()));
+        arena.append(_words[id]);
+        arena.push_back('\0');
+    }
+    offsets.push_back(static_cast<uint32_t>(arena.size()));
+    h.word_offsets = appendSection(out, offsets.data(), offsets.size());
+    h.arena        = appendSection(out, arena.data(), arena.size());
+    h.arena_size   = arena.size();
+
+    std::vector<uint32_t> vocab_slots;
+    if (!_words.empty()) {
+        h.vocab_slot_count = 2;
+        while (h.vocab_slot_count < 2 * h.vocab_size) h.vocab_slot_count *= 2;
+        vocab_slots.assign(h.vocab_slot_count, kNoWord);
+        const uint32_t mask = h.vocab_slot_count - 1;
+        for (uint32_t id = 0; id < h.vocab_size; id++) {
+            const std::string& w = _words[sorted[id]];
+            uint32_t i = static_cast<uint32_t>(hashWord(w.data(), w.size())) & mask;
+            while (vocab_slots[i] != kNoWord) i = (i + 1) & mask;
+            vocab_slots[i] = id;
+        }
+    }
+    h.vocab_slots = appendSection(out, vocab_slots.data(), vocab_slots.size());
+
+    std::vector<uint32_t> ids(_unigrams.size());
+    for (size_t i = 0; i < ids.size(); i++) ids[i] = rank[_unigrams[i]];
+    h.unigram_ids   = appendSection(out, ids.data(), ids.size());
+    h.unigram_freqs = appendSection(out, _unigram_freqs.data(), _unigram_freqs.size());
+
+    // Prefix index: positions grouped by word, then the sparse table
+    const uint32_t n = static_cast<uint32_t>(ids.size());
+    std::vector<uint32_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&ids](uint32_t a, uint32_t b) { return ids[a] < ids[b]; });
+    std::vector<uint32_t> word_unigrams(_words.size() + 1, 0);
+    for (uint32_t id : ids) word_unigrams[id + 1]++;
+    for (size_t i = 1; i < word_unigrams.size(); i++) word_unigrams[i] += word_unigrams[i - 1];
+
+    h.rmq_levels = 0;
+    while (n >> h.rmq_levels) h.rmq_levels++;
+    std::vector<uint32_t> rmq(size_t(h.rmq_levels) * n);
+    for (uint32_t i = 0; i < n; i++) rmq[i] = i;
+    for (uint32_t j = 1; j < h.rmq_levels; j++) {
+        const uint32_t* below = rmq.data() + size_t(j - 1) * n;
+        uint32_t*       row   = rmq.data() + size_t(j) * n;
+        const uint32_t  half  = 1u << (j - 1);
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t a = below[i], b = i + half < n ? below[i + half] : a;
+            row[i] = order[b] < order[a] ? b : a;
+        }
+    }
+    h.unigram_order = appendSection(out, order.data(), order.size());
+    h.word_unigrams = appendSection(out, word_unigrams.data(), word_unigrams.size());
+    h.unigram_rmq   = appendSection(out, rmq.data(), rmq.size());
+
+    // Trie, breadth first so each node's children are contiguous. A node
+    // at depth d over sorted ids [lo, hi) has one child per distinct byte d
+    // among those words (a word of length d, if any, sorts first).
+    std::vector<TrieNode> trie;
+    std::vector<uint32_t> top;
+    std::unordered_map<uint64_t, uint32_t> shared;      // (lo, hi) -> offset in top
+    std::vector<uint32_t> depth;
+    trie.push_back(TrieNode{ 0, static_cast<uint32_t>(_words.size()), 0, 0, 0, 0, 0 });
+    depth.push_back(0);
+    for (size_t at = 0; at < trie.size() && !_words.empty(); at++) {
+        const uint32_t d  = depth[at];
+        const uint32_t lo = trie[at].lo, hi = trie[at].hi;
+        const uint32_t first = static_cast<uint32_t>(trie.size());
+        for (uint32_t i = lo; i < hi; ) {
+            const std::string& w = _words[sorted[i]];
+            if (w.size() == d) {
+                i++;
+                continue;
+            }
+            uint32_t j = i + 1;
+            while (j < hi && static_cast<uint8_t>(_words[sorted[j]][d]) == static_cast<uint8_t>(w[d])) j++;
+            trie.push_back(TrieNode{ i, j, 0, 0, 0, 0, static_cast<uint8_t>(w[d]) });
+            depth.push_back(d + 1);
+            i = j;
+        }
+        trie[at].first_child = first;
+        trie[at].child_count = static_cast<uint16_t>(trie.size() - first);
+
+        // The first kTopK list positions among the node's unigram entries
+        uint64_t key = uint64_t(lo) << 32 | hi;
+        auto it = shared.find(key);
+        uint32_t begin = word_unigrams[lo], end = word_unigrams[hi];
+        uint32_t count = std::min<uint32_t>(kTopK, end - begin);
+        if (it == shared.end()) {
+            std::vector<uint32_t> positions(order.begin() + begin, order.begin() + end);
+            std::partial_sort(positions.begin(), positions.begin() + count, positions.end());
+            it = shared.emplace(key, static_cast<uint32_t>(top.size())).first;
+            top.insert(top.end(), positions.begin(), positions.begin() + count);
+        }
+        trie[at].top       = it->second;
+        trie[at].top_count = static_cast<uint8_t>(count);
+    }
+    h.trie_node_count = static_cast<uint32_t>(trie.size());
+    h.trie_top_count  = static_cast<uint32_t>(top.size());
+    h.trie_nodes      = appendSection(out, trie.data(), trie.size());
+    h.trie_top        = appendSection(out, top.data(), top.size());
+
+    h.key_bits = keyBits(_words.size());
+    for (int order = 2; order <= kMaxOrder; order++) {
+        const int        k    = order - 1;
+        std::vector<Row> rows = _rows[order];
+        for (Row& r : rows)
+            for (int i = 0; i < order; i++) r.words[i] = rank[r.words[i]];
+        // Stable, so a context's successors keep their CSV order
+        std::stable_sort(rows.begin(), rows.end(), [k](const Row& a, const Row& b) {
+            return std::lexicographical_compare(a.words, a.words + k, b.words, b.words + k);
+        });
+
+        std::vector<uint32_t> contexts, starts, successors;
+        std::vector<uint64_t> freqs;
+        for (size_t i = 0; i < rows.size(); i++) {
+            if (i == 0 || !std::equal(rows[i].words, rows[i].words + k, rows[i - 1].words)) {
+                contexts.insert(contexts.end(), rows[i].words, rows[i].words + k);
+                starts.push_back(static_cast<uint32_t>(successors.size()));
+            }
+            successors.push_back(rows[i].words[k]);
+            freqs.push_back(rows[i].freq);
+        }
+        starts.push_back(static_cast<uint32_t>(successors.size()));
+
+        OrderTable& t = h.orders[order];
+        t.context_count   = static_cast<uint32_t>(starts.size() - 1);
+        t.successor_count = static_cast<uint32_t>(successors.size());
+        t.key_words       = keyWords(order, h.key_bits);
+        std::vector<uint64_t> keys(size_t(t.context_count) * t.key_words);
+        for (uint32_t c = 0; c < t.context_count; c++) {
+            uint64_t key[kMaxKeyWords];
+            packKey(&contexts[size_t(c) * k], k, h.key_bits, key);
+            std::copy(key, key + t.key_words, &keys[size_t(c) * t.key_words]);
+        }
+        std::vector<uint16_t> pilots;
+        std::vector<uint32_t> remap;
+        std::vector<uint32_t> slot_of = buildMph(t, keys, pilots, remap);
+
+        // Contexts, and their successor runs, in slot order
+        std::vector<uint32_t> at(t.context_count);
+        for (uint32_t c = 0; c < t.context_count; c++) at[slot_of[c]] = c;
+        std::vector<uint64_t> slots, slot_keys;
+        std::vector<uint32_t> slot_successors;
+        std::vector<uint64_t> slot_freqs;
+        for (uint32_t c : at) {
+            const uint64_t* key = &keys[size_t(c) * t.key_words];
+            slots.push_back(slot_successors.size() | uint64_t(fingerprint(hashKey(key, t.key_words, t.seed))) << 32);
+            slot_keys.insert(slot_keys.end(), key, key + t.key_words);
+            slot_successors.insert(slot_successors.end(), successors.begin() + starts[c], successors.begin() + starts[c + 1]);
+            slot_freqs.insert(slot_freqs.end(), freqs.begin() + starts[c], freqs.begin() + starts[c + 1]);
+        }
+        slots.push_back(t.successor_count);
+
+        t.pilots     = appendSection(out, pilots.data(), pilots.size());
+        t.remap      = appendSection(out, remap.data(), remap.size());
+        t.slots      = appendSection(out, slots.data(), slots.size());
+        t.keys       = appendSection(out, slot_keys.data(), slot_keys.size());
+        t.successors = appendSection(out, slot_successors.data(), slot_successors.size());
+        t.freqs      = appendSection(out, slot_freqs.data(), slot_freqs.size());
+    }
+
+    h.file_size = out.size();
+    memcpy(out.data(), &h, sizeof(h));
+
+    // Write beside the target and rename, so readers see the old or new file
+    char tmp[4096];
+    snprintf(tmp, sizeof(tmp), "%s.%d.tmp", path, static_cast<int>(getpid()));
+    FILE* f = fopen(tmp, "wb");
+    if (!f) return strerror(errno);
+    bool ok = fwrite(out.data(), 1, out.size(), f) == out.size();
+    int  err = ok ? 0 : errno;
+    if (fclose(f) != 0 && ok) {
+        ok  = false;
+        err = errno;
+    }
+    if (ok && rename(tmp, path) != 0) {
+        ok  = false;
+        err = errno;
+    }
+    if (!ok) {
+        unlink(tmp);
+        return strerror(err);
+    }
+    return nullptr;
+}
+
+} // namespace ngram
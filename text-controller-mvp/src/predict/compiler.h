@@ -0,0 +1,49 @@
+#ifndef NGRAM_COMPILER_H
+#define NGRAM_COMPILER_H
+
+// Builds the model file described in model.h.
+//
+// Rows go in as predictor.py reads them: normalised words, in CSV order.
+// write() assigns the sorted word ids, groups each order's rows by context
+// (keeping their order within a context) and writes the file under a
+// temporary name, renaming it into place so a reader never sees half a
+// model.
+
+#include "model.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ngram {
+
+class Compiler {
+public:
+    // False if the word is empty or holds a NUL
+    bool addUnigram(const char* word, size_t len, uint64_t freq);
+    // `words` holds `order` words: the context, then the successor
+    bool addNgram(int order, const char* const* words, const size_t* lens, uint64_t freq);
+
+    // nullptr on success, else strerror() of the failing call
+    const char* write(const char* path) const;
+
+    size_t vocabularySize() const { return _words.size(); }
+
+private:
+    struct Row {
+        uint32_t words[kMaxOrder];
+        uint64_t freq;
+    };
+
+    std::vector<std::string>                  _words;     // first-seen order
+    std::unordered_map<std::string, uint32_t> _ids;
+    std::vector<uint32_t>                     _unigrams;
+    std::vector<uint64_t>                     _unigram_freqs;
+    std::vector<Row>                          _rows[kMaxOrder + 1];
+
+    bool intern(const char* word, size_t len, uint32_t& id);
+};
+
+} // namespace ngram
+
+#endif // NGRAM_COMPILER_H
@@ -0,0 +1,138 @@
+#include "engine.h"
+
+#include <algorithm>
+
+namespace ngram {
+
+// Matching words in list order, at most `cap` of them
+void Engine::filter(IdSpan list, const TrieNode& prefix, size_t cap,
+                    std::vector<uint32_t>& out) const {
+    out.clear();
+    for (size_t i = 0; i < list.size && out.size() < cap; i++)
+        if (matches(list.ids[i], prefix)) out.push_back(list.ids[i]);
+}
+
+// predictor.py's _merge: append matches not among the candidates so far
+// (only those; a list's own repeats stay)
+void Engine::merge(IdSpan list, const TrieNode& prefix, size_t cap,
+                   std::vector<uint32_t>& out, bool& added) const {
+    size_t primary = out.size();
+    added = false;
+    for (size_t j = 0; j < list.size && out.size() < cap; j++) {
+        if (!matches(list.ids[j], prefix)) continue;
+        added = true;
+        appendUnique(list.ids[j], primary, out);
+    }
+}
+
+void Engine::appendUnique(uint32_t id, size_t primary, std::vector<uint32_t>& out) {
+    for (size_t i = 0; i < primary; i++)
+        if (out[i] == id) return;
+    out.push_back(id);
+}
+
+// merge() over the unigram list without scanning it. The node's top list
+// is usually enough; past it, the node's words are one run of the index,
+// and splitting runs around their first position yields the matches in
+// list order.
+void Engine::mergeUnigrams(const TrieNode& prefix, size_t cap,
+                           std::vector<uint32_t>& out, bool& added) const {
+    const IdSpan    list    = _model.unigrams();
+    const uint32_t* top     = _model.topUnigrams(prefix);
+    const size_t    primary = out.size();
+    size_t i = 0;
+    for (; i < prefix.top_count && out.size() < cap; i++) appendUnique(list.ids[top[i]], primary, out);
+    added = i > 0;
+    if (out.size() == cap || i == _model.unigramsIn(prefix)) return;
+
+    out.resize(primary);
+    _runs.clear();
+    pushRun(_model.wordUnigrams(prefix.lo), _model.wordUnigrams(prefix.hi));
+    while (!_runs.empty() && out.size() < cap) {
+        std::pop_heap(_runs.begin(), _runs.end(), laterRun);
+        Run run = _runs.back();
+        _runs.pop_back();
+        pushRun(run.begin, run.at);
+        pushRun(run.at + 1, run.end);
+        appendUnique(list.ids[run.position], primary, out);
+    }
+}
+
+// Runs form a heap, smallest first position on top
+void Engine::pushRun(uint32_t begin, uint32_t end) const {
+    if (begin == end) return;
+    uint32_t at = _model.firstUnigram(begin, end);
+    _runs.push_back({ _model.unigramPosition(at), at, begin, end });
+    std::push_heap(_runs.begin(), _runs.end(), laterRun);
+}
+
+void Engine::suggest(const char* prefix, size_t prefix_len, const char* const* words,
+                     const size_t* word_lens, size_t nwords, size_t max_results,
+                     Suggestions& out) const {
+    // Candidates past max_results are never returned, and the stage
+    // conditions only ask whether there are fewer than max_results; keep
+    // at least one so a 0 limit still tells hits from none
+    const size_t cap = max_results ? max_results : 1;
+    out.words.clear();
+    out.level   = 0;
+    out.context = -1;
+
+    // No word starts with the prefix: nothing can match at any order
+    static const TrieNode kNone{};
+    const TrieNode* node = _model.findPrefix(prefix, prefix_len);
+    if (!node) node = &kNone;
+
+    // A context with an unknown word has no entry at any order using it
+    uint32_t ids[kMaxOrder - 1];
+    size_t   known = 0;      // trailing context words in the vocabulary
+    if (nwords > kMaxOrder - 1) {
+        words     += nwords - (kMaxOrder - 1);
+        word_lens += nwords - (kMaxOrder - 1);
+        nwords     = kMaxOrder - 1;
+    }
+    for (size_t i = nwords; i > 0; i--) {
+        ids[i - 1] = _model.findWord(words[i - 1], word_lens[i - 1]);
+        if (ids[i - 1] == kNoWord) break;
+        known++;
+    }
+
+    for (int order = kMaxOrder; order >= 3; order--) {
+        if (order < kMaxOrder && out.words.size() >= max_results) break;
+        if (known < static_cast<size_t>(order - 1)) continue;
+        IdSpan list = _model.successors(order, ids + nwords - (order - 1));
+        if (!list.size) continue;
+        // Hits replace the candidates; no hits leave them alone
+        filter(list, *node, cap, _hits);
+        if (_hits.empty()) continue;
+        out.words.swap(_hits);
+        out.level   = order;
+        out.context = order - 1;
+    }
+
+    bool added;
+    if (out.words.size() < max_results && known >= 1) {
+        merge(_model.successors(2, ids + nwords - 1), *node, cap, out.words, added);
+        if (out.level == 0 && added) {
+            out.level   = 2;
+            out.context = 1;
+        }
+    }
+
+    if (out.words.size() < max_results) {
+        mergeUnigrams(*node, cap, out.words, added);
+        if (out.level == 0 && added) {
+            out.level   = 1;
+            out.context = 0;
+        }
+    }
+
+    if (out.words.empty()) {
+        IdSpan top = _model.unigrams();
+        for (size_t i = 0; i < top.size && i < max_results; i++) out.words.push_back(top.ids[i]);
+        out.level   = 1;
+        out.context = -1;
+    }
+    if (out.words.size() > max_results) out.words.resize(max_results);
+}
+
+} // namespace ngram
@@ -0,0 +1,71 @@
+#ifndef NGRAM_ENGINE_H
+#define NGRAM_ENGINE_H
+
+// Word prediction with the backoff of predictor.py, for the Python app.
+//
+// Works straight off a compiled model (model.h): tables hold word ids, and
+// suggestions come back as ids. Results match
+// PredictiveText.get_suggestions exactly, including its quirks:
+//   - 5G, 4G and 3G hits replace the candidates, they are not merged;
+//   - 2G and 1G hits are appended, skipping words already suggested,
+//     but a list's own duplicates are kept (the CSVs fold case, so
+//     "The" and "the" both become THE);
+//   - with no candidates at all, the most common words are returned.
+// Callers normalise first (strip, upper-case, split the context), so the
+// engine only ever sees the strings Python would compare.
+//
+// suggest() allocates nothing once its scratch has grown to max_results,
+// and is not thread-safe: give each thread its own Engine.
+
+#include "model.h"
+
+#include <vector>
+
+namespace ngram {
+
+struct Suggestions {
+    std::vector<uint32_t> words;
+    int level;      // n-gram order that produced them: 1..5, 0 = none
+    int context;    // context words used as the key; 0 = the prefix, -1 = none
+};
+
+class Engine {
+public:
+    // nullptr on success, else why the model was rejected
+    const char* open(const char* path) { return _model.open(path); }
+
+    const Model& model() const { return _model; }
+
+    // `words` are the last `nwords` context words, oldest first
+    void suggest(const char* prefix, size_t prefix_len, const char* const* words,
+                 const size_t* word_lens, size_t nwords, size_t max_results,
+                 Suggestions& out) const;
+
+private:
+    // A run of the unigram prefix index, keyed by its first list position
+    struct Run {
+        uint32_t position;
+        uint32_t at;
+        uint32_t begin, end;
+    };
+
+    Model                         _model;
+    mutable std::vector<uint32_t> _hits;     // lookup scratch
+    mutable std::vector<Run>      _runs;
+
+    // A word starts with the prefix iff its id is in the node's range
+    static bool matches(uint32_t id, const TrieNode& prefix) { return id - prefix.lo < prefix.hi - prefix.lo; }
+    static void appendUnique(uint32_t id, size_t primary, std::vector<uint32_t>& out);
+
+    void filter(IdSpan list, const TrieNode& prefix, size_t cap, std::vector<uint32_t>& out) const;
+    void merge(IdSpan list, const TrieNode& prefix, size_t cap,
+               std::vector<uint32_t>& out, bool& added) const;
+    void mergeUnigrams(const TrieNode& prefix, size_t cap,
+                       std::vector<uint32_t>& out, bool& added) const;
+    void pushRun(uint32_t begin, uint32_t end) const;
+    static bool laterRun(const Run& a, const Run& b) { return a.position > b.position; }
+};
+
+} // namespace ngram
+
+#endif // NGRAM_ENGINE_H
@@ -0,0 +1,283 @@
+#include "model.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace ngram {
+
+Model::Model()
+    : _fd(-1), _base(nullptr), _size(0), _header{}, _word_offsets(nullptr), _arena(nullptr),
+      _vocab_slots(nullptr), _unigram_ids(nullptr), _unigram_freqs(nullptr), _unigram_order(nullptr),
+      _word_unigrams(nullptr), _unigram_rmq(nullptr), _trie(nullptr), _trie_top(nullptr),
+      _orders{} {}
+
+Model::~Model() {
+    close();
+}
+
+const char* Model::open(const char* path) {
+    close();
+    _fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (_fd < 0) return strerror(errno);
+
+    struct stat st;
+    if (fstat(_fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(FileHeader)) {
+        close();
+        return "is truncated";
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+
+    void* m = mmap(nullptr, size, PROT_READ, MAP_SHARED, _fd, 0);
+    if (m == MAP_FAILED) {
+        const char* error = strerror(errno);
+        close();
+        return error;
+    }
+    madvise(m, size, MADV_WILLNEED);
+
+    const char* error = attach(static_cast<const uint8_t*>(m), size);
+    if (error) close();
+    return error;
+}
+
+const char* Model::openBuffer(const uint8_t* data, size_t size) {
+    close();
+    const char* error = attach(data, size);
+    if (error) close();
+    return error;
+}
+
+void Model::close() {
+    if (_base && _fd >= 0) munmap(const_cast<uint8_t*>(_base), _size);
+    if (_fd >= 0) ::close(_fd);
+    _fd   = -1;
+    _base = nullptr;
+    _size = 0;
+    _header = FileHeader{};
+}
+
+// The section at `offset` holding `count` elements, or nullptr when it is
+// misaligned or runs past the end. Every bound is checked without
+// overflow: the header may be garbage.
+const void* Model::section(uint64_t offset, uint64_t count, size_t elem) const {
+    if (offset % 8 != 0 || offset > _size) return nullptr;
+    if (count > (_size - offset) / elem) return nullptr;
+    return _base + offset;
+}
+
+const char* Model::attach(const uint8_t* base, size_t size) {
+    _base = base;
+    _size = size;
+    if (_size < sizeof(FileHeader)) return "is truncated";
+    memcpy(&_header, _base, sizeof(_header));
+    if (memcmp(_header.magic, kFileMagic, sizeof(kFileMagic)) != 0) return "is not an n-gram model";
+    if (_header.version != kFormatVersion || _header.header_size != sizeof(FileHeader))
+        return "has an unsupported format version";
+    if (_header.file_size != _size) return "is truncated";
+
+    const FileHeader& h = _header;
+    _word_offsets  = static_cast<const uint32_t*>(section(h.word_offsets, uint64_t(h.vocab_size) + 1, 4));
+    _arena         = static_cast<const char*>(section(h.arena, h.arena_size, 1));
+    _unigram_ids   = static_cast<const uint32_t*>(section(h.unigram_ids, h.unigram_count, 4));
+    _unigram_freqs = static_cast<const uint64_t*>(section(h.unigram_freqs, h.unigram_count, 8));
+    if (!_word_offsets || !_arena || !_unigram_ids || !_unigram_freqs) return "has a section out of bounds";
+
+    // Words must be NUL-terminated, in strictly increasing byte order
+    if (_word_offsets[0] != 0 || _word_offsets[h.vocab_size] != h.arena_size) return "has a bad vocabulary";
+    for (uint32_t i = 0; i < h.vocab_size; i++) {
+        uint32_t begin = _word_offsets[i], end = _word_offsets[i + 1];
+        if (end <= begin || end > h.arena_size) return "has a bad vocabulary";
+        if (memchr(_arena + begin, '\0', end - begin) != _arena + end - 1) return "has a bad vocabulary";
+        if (i > 0 && strcmp(_arena + _word_offsets[i - 1], _arena + begin) >= 0) return "has an unsorted vocabulary";
+    }
+    if (const char* error = checkVocabularyTable()) return error;
+    for (uint32_t i = 0; i < h.unigram_count; i++)
+        if (_unigram_ids[i] >= h.vocab_size) return "has a bad unigram";
+    if (const char* error = checkUnigramIndex()) return error;
+    if (const char* error = checkTrie()) return error;
+
+    if (h.key_bits != keyBits(h.vocab_size)) return "has a bad key width";
+    for (int order = 2; order <= kMaxOrder; order++)
+        if (const char* error = checkTable(order)) return error;
+    return nullptr;
+}
+
+// Every word once, and an empty slot for a probe to stop at
+const char* Model::checkVocabularyTable() {
+    const FileHeader& h = _header;
+    const uint32_t    n = h.vocab_slot_count;
+    if (n & (n - 1)) return "has a bad vocabulary table";
+    if (n ? h.vocab_size >= n : h.vocab_size != 0) return "has a bad vocabulary table";
+    _vocab_slots = static_cast<const uint32_t*>(section(h.vocab_slots, n, 4));
+    if (!_vocab_slots) return "has a section out of bounds";
+    uint32_t used = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        if (_vocab_slots[i] == kNoWord) continue;
+        if (_vocab_slots[i] >= h.vocab_size) return "has a bad vocabulary table";
+        used++;
+    }
+    return used == h.vocab_size ? nullptr : "has a bad vocabulary table";
+}
+
+// The prefix index must agree with unigram_ids, and every sparse table
+// cell must pick one of the two cells below it, so a query always lands
+// inside its range whatever the file holds
+const char* Model::checkUnigramIndex() {
+    const FileHeader& h = _header;
+    const uint32_t    n = h.unigram_count;
+    uint32_t levels = 1;
+    while (n >> levels) levels++;
+    if (h.rmq_levels != (n ? levels : 0)) return "has a bad unigram index";
+
+    _unigram_order = static_cast<const uint32_t*>(section(h.unigram_order, n, 4));
+    _word_unigrams = static_cast<const uint32_t*>(section(h.word_unigrams, uint64_t(h.vocab_size) + 1, 4));
+    _unigram_rmq   = static_cast<const uint32_t*>(section(h.unigram_rmq, uint64_t(h.rmq_levels) * n, 4));
+    if (!_unigram_order || !_word_unigrams || !_unigram_rmq) return "has a section out of bounds";
+
+    if (_word_unigrams[0] != 0 || _word_unigrams[h.vocab_size] != n) return "has a bad unigram index";
+    for (uint32_t id = 0; id < h.vocab_size; id++) {
+        if (_word_unigrams[id + 1] < _word_unigrams[id]) return "has a bad unigram index";
+        for (uint32_t i = _word_unigrams[id]; i < _word_unigrams[id + 1]; i++) {
+            uint32_t pos = _unigram_order[i];
+            if (pos >= n || _unigram_ids[pos] != id) return "has a bad unigram index";
+        }
+    }
+    for (uint32_t i = 0; i < n; i++)
+        if (_unigram_rmq[i] != i) return "has a bad unigram index";
+    for (uint32_t j = 1; j < h.rmq_levels; j++) {
+        const uint32_t* below = _unigram_rmq + size_t(j - 1) * n;
+        const uint32_t* row   = _unigram_rmq + size_t(j) * n;
+        const uint32_t  half  = 1u << (j - 1);
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t right = i + half < n ? below[i + half] : below[i];
+            if (row[i] != below[i] && row[i] != right) return "has a bad unigram index";
+        }
+    }
+    return nullptr;
+}
+
+// Children must come after their parent and inside the node array, and
+// ranges and top lists inside theirs
+const char* Model::checkTrie() {
+    const FileHeader& h = _header;
+    _trie     = static_cast<const TrieNode*>(section(h.trie_nodes, h.trie_node_count, sizeof(TrieNode)));
+    _trie_top = static_cast<const uint32_t*>(section(h.trie_top, h.trie_top_count, 4));
+    if (!_trie || !_trie_top) return "has a section out of bounds";
+    if (h.vocab_size > 0 && h.trie_node_count == 0) return "has no trie";
+
+    for (uint32_t i = 0; i < h.trie_node_count; i++) {
+        const TrieNode& n = _trie[i];
+        if (n.child_count && (n.first_child <= i || n.first_child > h.trie_node_count
+                              || n.child_count > h.trie_node_count - n.first_child))
+            return "has a bad trie";
+        if (n.lo > n.hi || n.hi > h.vocab_size) return "has a bad trie";
+        if (n.top_count > kTopK || n.top > h.trie_top_count || n.top_count > h.trie_top_count - n.top)
+            return "has a bad trie";
+        if (n.top_count != std::min<uint32_t>(kTopK, unigramsIn(n))) return "has a bad trie";
+    }
+    for (uint32_t i = 0; i < h.trie_top_count; i++)
+        if (_trie_top[i] >= h.unigram_count) return "has a bad trie";
+    return nullptr;
+}
+
+// The MPH must land inside the slots, and the slots' starts must split
+// the successors into non-empty runs
+const char* Model::checkTable(int order) {
+    const OrderTable& t = _header.orders[order];
+    Order&            o = _orders[order];
+    if (t.key_words != keyWords(order, _header.key_bits)) return "has a bad n-gram table";
+    if (t.table_size < t.context_count) return "has a bad n-gram table";
+    if (t.context_count && !t.bucket_count) return "has a bad n-gram table";
+
+    o.pilots     = static_cast<const uint16_t*>(section(t.pilots, t.bucket_count, 2));
+    o.remap      = static_cast<const uint32_t*>(section(t.remap, t.table_size - t.context_count, 4));
+    o.slots      = static_cast<const uint64_t*>(section(t.slots, uint64_t(t.context_count) + 1, 8));
+    o.keys       = static_cast<const uint64_t*>(section(t.keys, uint64_t(t.context_count) * t.key_words, 8));
+    o.successors = static_cast<const uint32_t*>(section(t.successors, t.successor_count, 4));
+    o.freqs      = static_cast<const uint64_t*>(section(t.freqs, t.successor_count, 8));
+    if (!o.pilots || !o.remap || !o.slots || !o.keys || !o.successors || !o.freqs)
+        return "has a section out of bounds";
+
+    for (uint32_t i = 0; i < t.table_size - t.context_count; i++)
+        if (o.remap[i] >= t.context_count) return "has a bad n-gram table";
+    if (static_cast<uint32_t>(o.slots[0]) != 0) return "has a bad n-gram table";
+    for (uint32_t i = 0; i < t.context_count; i++)
+        if (static_cast<uint32_t>(o.slots[i]) >= static_cast<uint32_t>(o.slots[i + 1]))
+            return "has a bad n-gram table";
+    if (static_cast<uint32_t>(o.slots[t.context_count]) != t.successor_count) return "has a bad n-gram table";
+    for (uint32_t i = 0; i < t.successor_count; i++)
+        if (o.successors[i] >= _header.vocab_size) return "has a bad n-gram successor";
+    return nullptr;
+}
+
+// ── Lookup ─────────────────────────────────────────────────────────────────
+
+uint32_t Model::findWord(const char* word, size_t len) const {
+    const uint32_t n = _header.vocab_slot_count;
+    if (!n) return kNoWord;
+    for (uint32_t i = static_cast<uint32_t>(hashWord(word, len)) & (n - 1); ; i = (i + 1) & (n - 1)) {
+        uint32_t id = _vocab_slots[i];
+        if (id == kNoWord) return kNoWord;
+        if (wordLength(id) == len && memcmp(this->word(id), word, len) == 0) return id;
+    }
+}
+
+const TrieNode* Model::findPrefix(const char* prefix, size_t len) const {
+    if (_header.trie_node_count == 0) return nullptr;
+    const TrieNode* node = _trie;
+    for (size_t i = 0; i < len; i++) {
+        const uint8_t   c     = static_cast<uint8_t>(prefix[i]);
+        const TrieNode* first = _trie + node->first_child;
+        const TrieNode* last  = first + node->child_count;
+        const TrieNode* child = std::lower_bound(first, last, c,
+            [](const TrieNode& n, uint8_t label) { return n.label < label; });
+        if (child == last || child->label != c) return nullptr;
+        node = child;
+    }
+    return node;
+}
+
+uint32_t Model::firstUnigram(uint32_t begin, uint32_t end) const {
+    const uint32_t n = _header.unigram_count;
+    uint32_t j = 0;
+    while ((end - begin) >> (j + 1)) j++;
+    uint32_t a = _unigram_rmq[size_t(j) * n + begin];
+    uint32_t b = _unigram_rmq[size_t(j) * n + end - (1u << j)];
+    return _unigram_order[b] < _unigram_order[a] ? b : a;
+}
+
+IdSpan Model::successors(int order, const uint32_t* context) const {
+    const OrderTable& t = _header.orders[order];
+    if (!t.context_count) return { nullptr, 0 };
+    uint64_t key[kMaxKeyWords];
+    packKey(context, order - 1, _header.key_bits, key);
+
+    const Order&   o    = _orders[order];
+    const uint64_t hash = hashKey(key, t.key_words, t.seed);
+    uint32_t slot = mphPosition(hash, o.pilots[mphBucket(hash, t.bucket_count)], t.table_size);
+    if (slot >= t.context_count) slot = o.remap[slot - t.context_count];
+
+    const uint64_t meta = o.slots[slot];
+    if (static_cast<uint16_t>(meta >> 32) != fingerprint(hash)) return { nullptr, 0 };
+    const uint64_t* stored = o.keys + size_t(slot) * t.key_words;
+    if (stored[0] != key[0] || (t.key_words == 2 && stored[1] != key[1])) return { nullptr, 0 };
+    const uint32_t start = static_cast<uint32_t>(meta);
+    return { o.successors + start, static_cast<uint32_t>(o.slots[slot + 1]) - start };
+}
+
+void Model::slotContext(int order, uint32_t slot, uint32_t* context) const {
+    const OrderTable& t    = _header.orders[order];
+    const uint64_t*   key  = _orders[order].keys + size_t(slot) * t.key_words;
+    const uint32_t    bits = _header.key_bits;
+    for (int i = 0; i < order - 1; i++) {
+        uint32_t bit = static_cast<uint32_t>(i) * bits;
+        context[i] = static_cast<uint32_t>((key[bit / 64] >> (bit % 64)) & ((uint64_t(1) << bits) - 1));
+    }
+}
+
+} // namespace ngram
@@ -0,0 +1,263 @@
+#ifndef NGRAM_MODEL_H
+#define NGRAM_MODEL_H
+
+// Compiled n-gram model, used in place through mmap.
+//
+// File layout (little-endian, every section 8-byte aligned):
+//   FileHeader
+//   word_offsets  u32[vocab_size + 1]   word i is arena[off[i], off[i+1] - 1)
+//   arena         words, each followed by a NUL
+//   vocab_slots   u32[vocab_slot_count] word ids by hashWord, kNoWord = empty
+//   unigram_ids   u32[unigram_count]    CSV order (most frequent first)
+//   unigram_freqs u64[unigram_count]
+//   unigram_order u32[unigram_count]    list positions sorted by (word id, position)
+//   word_unigrams u32[vocab_size + 1]   word i's run in unigram_order
+//   unigram_rmq   u32[rmq_levels * unigram_count]   sparse table over unigram_order:
+//                 row j, column i = the index in [i, min(i + 2^j, n)) holding
+//                 the smallest position
+//   trie_nodes    TrieNode[trie_node_count]   breadth-first, node 0 = ""
+//   trie_top      u32[trie_top_count]         per-node top completions
+//   for each order 2..5, its contexts numbered by their minimal perfect hash:
+//     pilots      u16[bucket_count]                  MPH displacement per bucket
+//     remap       u32[table_size - context_count]    MPH positions past the end
+//     slots       u64[context_count + 1]             start | fingerprint << 32
+//     keys        u64[context_count * key_words]     packed context ids
+//     successors  u32[successor_count]               CSV order per context
+//     freqs       u64[successor_count]
+//
+// Word ids are ranks in byte order, so a prefix covers a contiguous id
+// range. Context words are interned through vocab_slots, a linear-probing
+// table at most half full, then their ids are packed key_bits apiece (16
+// while the vocabulary fits, else 32) into one or two u64s.
+//
+// Context tables are static, so each order has a minimal perfect hash
+// instead of a probing table (PTHash): a key hashes to one of about n/5
+// buckets, and the bucket's pilot moves it to a position in [0, m), m a
+// little over n, chosen at compile time so that no two keys collide.
+// Positions at or past n are remapped into the holes below it. The
+// pilots and remap cost under 4 bits per context. Slot i holds its
+// successors' start (the next slot's start ends them) and a 16-bit
+// fingerprint of the key: an absent context is turned away there, 65535
+// times in 65536, without reading the keys. The key itself is then
+// compared so answers stay exact. Lists keep the CSV order and their
+// case-folded repeats, since that is what predictor.py returns.
+//
+// A prefix is looked up by walking the trie, one node per byte. Each
+// node holds the id range of the words under it, so checking an n-gram
+// successor against the prefix is an integer compare, and the first
+// kTopK unigram list positions under it, so the unigram fallback is a
+// copy. Nodes covering the same range share one top list.
+//
+// When more than kTopK unigram matches are wanted, the node's range maps
+// to one run of unigram_order and the sparse table gives that run's
+// smallest position in O(1): the first k cost O(k log k).
+//
+// Nothing is parsed at load: open() checks the bounds of every section
+// once, and the pages are shared by every process using the file.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ngram {
+
+constexpr int      kMaxOrder      = 5;
+constexpr char     kFileMagic[8]  = { 'N', 'G', 'R', 'A', 'M', 'M', 'D', 'L' };
+constexpr uint32_t kFormatVersion = 5;
+constexpr uint32_t kNoWord        = 0xFFFFFFFF;
+constexpr uint32_t kTopK          = 8;     // covers max_results 3 plus 3 repeats of
+                                           // higher-order suggestions, and then some
+
+struct TrieNode {
+    uint32_t lo, hi;            // ids of the words starting with this prefix
+    uint32_t first_child;       // children are contiguous, sorted by label
+    uint32_t top;               // top_count list positions at trie_top[top]
+    uint16_t child_count;
+    uint8_t  top_count;         // min(kTopK, unigram entries in [lo, hi))
+    uint8_t  label;             // byte on the edge from the parent
+};
+
+struct OrderTable {
+    uint32_t context_count;     // n, also the number of slots
+    uint32_t successor_count;
+    uint32_t key_words;         // u64s per packed key
+    uint32_t bucket_count;
+    uint32_t table_size;        // m >= n, the MPH's range before remapping
+    uint32_t reserved;
+    uint64_t seed;
+    uint64_t pilots;            // section offsets from the start of the file
+    uint64_t remap;
+    uint64_t slots;
+    uint64_t keys;
+    uint64_t successors;
+    uint64_t freqs;
+};
+
+struct FileHeader {
+    char       magic[8];
+    uint32_t   version;
+    uint32_t   header_size;
+    uint64_t   file_size;
+    uint32_t   vocab_size;
+    uint32_t   unigram_count;
+    uint64_t   word_offsets;
+    uint64_t   arena;
+    uint64_t   arena_size;
+    uint64_t   unigram_ids;
+    uint64_t   unigram_freqs;
+    uint64_t   unigram_order;
+    uint64_t   word_unigrams;
+    uint64_t   unigram_rmq;
+    uint32_t   rmq_levels;
+    uint32_t   trie_node_count;
+    uint64_t   trie_nodes;
+    uint64_t   trie_top;
+    uint32_t   trie_top_count;
+    uint32_t   key_bits;            // bits per word id in packed context keys
+    uint64_t   vocab_slots;
+    uint32_t   vocab_slot_count;    // a power of two above vocab_size, or 0
+    uint32_t   reserved;
+    OrderTable orders[kMaxOrder + 1];   // [2..kMaxOrder] used
+};
+
+// ── Hashing ────────────────────────────────────────────────────────────────
+
+constexpr int kMaxKeyWords = 2;
+
+inline uint32_t keyBits(size_t vocab_size) { return vocab_size <= 0x10000 ? 16 : 32; }
+
+inline uint32_t keyWords(int order, uint32_t key_bits) {
+    return (static_cast<uint32_t>(order - 1) * key_bits + 63) / 64;
+}
+
+// Ids go in oldest first, from the low bits up
+inline void packKey(const uint32_t* ids, int k, uint32_t key_bits, uint64_t* key) {
+    key[0] = key[1] = 0;
+    for (int i = 0; i < k; i++) {
+        uint32_t bit = static_cast<uint32_t>(i) * key_bits;
+        key[bit / 64] |= uint64_t(ids[i]) << (bit % 64);
+    }
+}
+
+// murmur3's finaliser: every key bit reaches every hash bit
+inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+inline uint64_t hashWord(const char* word, size_t len) {
+    uint64_t h = 0xcbf29ce484222325ull;     // FNV-1a, then mixed: words are short
+    for (size_t i = 0; i < len; i++) h = (h ^ static_cast<uint8_t>(word[i])) * 0x100000001b3ull;
+    return mix64(h);
+}
+
+inline uint64_t hashKey(const uint64_t* key, uint32_t key_words, uint64_t seed) {
+    uint64_t h = key_words == 1 ? key[0] : key[0] ^ mix64(key[1] + 0x9E3779B97F4A7C15ull);
+    return mix64(h ^ seed);
+}
+
+// ── Minimal perfect hashing ────────────────────────────────────────────────
+
+constexpr uint32_t kBucketSize = 5;         // average keys per bucket
+constexpr uint32_t kMaxPilot   = 0xFFFF;
+
+// x scaled to [0, n) without a division
+inline uint32_t fastRange(uint64_t x, uint32_t n) {
+    return static_cast<uint32_t>((static_cast<unsigned __int128>(x) * n) >> 64);
+}
+
+inline uint32_t mphBucket(uint64_t hash, uint32_t buckets) { return fastRange(hash, buckets); }
+
+inline uint32_t mphPosition(uint64_t hash, uint32_t pilot, uint32_t table_size) {
+    return fastRange(mix64(hash ^ (uint64_t(pilot) * 0x9E3779B97F4A7C15ull + 1)), table_size);
+}
+
+inline uint16_t fingerprint(uint64_t hash) { return static_cast<uint16_t>(hash); }
+
+// A run of word ids inside the model
+struct IdSpan {
+    const uint32_t* ids;
+    size_t          size;
+};
+
+class Model {
+public:
+    Model();
+    ~Model();
+    Model(const Model&)            = delete;
+    Model& operator=(const Model&) = delete;
+
+    // nullptr on success, else why the file was rejected
+    const char* open(const char* path);
+    const char* openBuffer(const uint8_t* data, size_t size);
+    void close();
+
+    size_t vocabularySize() const { return _header.vocab_size; }
+    const char* word(uint32_t id) const { return _arena + _word_offsets[id]; }
+    size_t wordLength(uint32_t id) const { return _word_offsets[id + 1] - _word_offsets[id] - 1; }
+    uint32_t findWord(const char* word, size_t len) const;     // kNoWord if absent
+
+    // The trie node of `prefix`, nullptr when no word starts with it
+    const TrieNode* findPrefix(const char* prefix, size_t len) const;
+    const uint32_t* topUnigrams(const TrieNode& node) const { return _trie_top + node.top; }
+    // Unigram list entries whose word is in [lo, hi)
+    uint32_t unigramsIn(const TrieNode& node) const {
+        return _word_unigrams[node.hi] - _word_unigrams[node.lo];
+    }
+
+    IdSpan unigrams() const { return { _unigram_ids, _header.unigram_count }; }
+    const uint64_t* unigramFreqs() const { return _unigram_freqs; }
+    // Words lo..hi-1 have list positions unigramPosition(i) for i in
+    // [wordUnigrams(lo), wordUnigrams(hi))
+    uint32_t wordUnigrams(uint32_t id) const { return _word_unigrams[id]; }
+    uint32_t unigramPosition(uint32_t i) const { return _unigram_order[i]; }
+    // The i in [begin, end) with the smallest position; begin < end
+    uint32_t firstUnigram(uint32_t begin, uint32_t end) const;
+    size_t contextCount(int order) const { return _header.orders[order].context_count; }
+    // Successors of the `order - 1` context ids, empty if none
+    IdSpan successors(int order, const uint32_t* context) const;
+    // The ids of the context in slot `slot` < contextCount(order)
+    void slotContext(int order, uint32_t slot, uint32_t* context) const;
+
+    const FileHeader& header() const { return _header; }
+
+private:
+    struct Order {
+        const uint16_t* pilots;
+        const uint32_t* remap;
+        const uint64_t* slots;
+        const uint64_t* keys;
+        const uint32_t* successors;
+        const uint64_t* freqs;
+    };
+
+    int            _fd;
+    const uint8_t* _base;
+    size_t         _size;
+    FileHeader     _header;
+    const uint32_t* _word_offsets;
+    const char*     _arena;
+    const uint32_t* _vocab_slots;
+    const uint32_t* _unigram_ids;
+    const uint64_t* _unigram_freqs;
+    const uint32_t* _unigram_order;
+    const uint32_t* _word_unigrams;
+    const uint32_t* _unigram_rmq;
+    const TrieNode* _trie;
+    const uint32_t* _trie_top;
+    Order           _orders[kMaxOrder + 1];
+
+    const char* attach(const uint8_t* base, size_t size);
+    const char* checkVocabularyTable();
+    const char* checkUnigramIndex();
+    const char* checkTrie();
+    const char* checkTable(int order);
+    const void* section(uint64_t offset, uint64_t count, size_t elem) const;
+};
+
+} // namespace ngram
+
+#endif // NGRAM_MODEL_H
@@ -0,0 +1,349 @@
+// _ngram: the C++ engine as a Python extension, for predictor.py.
+//
+//   _ngram.compile(path, unigrams, ngrams)
+//   engine = _ngram.Engine(path)
+//   words, level, context = engine.suggest(prefix, context_words, max_results)
+//
+// compile() writes a model (model.h) from PredictiveText's CSV rows:
+// unigrams as (word, freq) and, for orders 2..5, lists of (words, freq),
+// all normalised and in CSV order. Engine maps the file. suggest() takes
+// the prefix already stripped and upper-cased and the context already
+// split, and returns what get_suggestions returns. A word's str is made
+// the first time it is suggested and reused after, so a call creates no
+// strings beyond the context label.
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "compiler.h"
+#include "engine.h"
+
+#include <new>
+
+namespace {
+
+constexpr Py_ssize_t kMaxContext = ngram::kMaxOrder - 1;
+
+struct EngineObject {
+    PyObject_HEAD
+    ngram::Engine*      engine;
+    ngram::Suggestions* result;
+    PyObject**          words;      // id -> str, made on first use
+    PyObject*           levels;     // tuple: "—", "1G" .. "5G"
+};
+
+// ── Compiling ──────────────────────────────────────────────────────────────
+
+// A (word or words, freq) row. False with an exception set on failure.
+bool parseRow(PyObject* row, PyObject*& words, unsigned long long& freq) {
+    if (!PyTuple_Check(row) || PyTuple_GET_SIZE(row) != 2) {
+        PyErr_SetString(PyExc_TypeError, "rows must be (ngram, freq) tuples");
+        return false;
+    }
+    words = PyTuple_GET_ITEM(row, 0);
+    freq  = PyLong_AsUnsignedLongLong(PyTuple_GET_ITEM(row, 1));
+    return !PyErr_Occurred();
+}
+
+bool utf8(PyObject* word, const char*& s, size_t& len) {
+    Py_ssize_t n;
+    if (!PyUnicode_Check(word)) {
+        PyErr_SetString(PyExc_TypeError, "words must be str");
+        return false;
+    }
+    if (!(s = PyUnicode_AsUTF8AndSize(word, &n))) return false;
+    len = static_cast<size_t>(n);
+    return true;
+}
+
+bool addUnigrams(ngram::Compiler& compiler, PyObject* rows) {
+    PyObject* seq = PySequence_Fast(rows, "unigrams must be a list");
+    if (!seq) return false;
+    bool ok = true;
+    for (Py_ssize_t i = 0; ok && i < PySequence_Fast_GET_SIZE(seq); i++) {
+        PyObject*          word;
+        unsigned long long freq;
+        const char*        s;
+        size_t             len;
+        ok = parseRow(PySequence_Fast_ITEMS(seq)[i], word, freq) && utf8(word, s, len);
+        if (ok && !compiler.addUnigram(s, len, freq)) {
+            PyErr_SetString(PyExc_ValueError, "words must be non-empty, without NULs");
+            ok = false;
+        }
+    }
+    Py_DECREF(seq);
+    return ok;
+}
+
+bool addNgrams(ngram::Compiler& compiler, int order, PyObject* rows) {
+    PyObject* seq = PySequence_Fast(rows, "n-gram rows must be a list");
+    if (!seq) return false;
+    bool ok = true;
+    for (Py_ssize_t i = 0; ok && i < PySequence_Fast_GET_SIZE(seq); i++) {
+        PyObject*          words;
+        unsigned long long freq;
+        ok = parseRow(PySequence_Fast_ITEMS(seq)[i], words, freq);
+        if (ok && (!PyTuple_Check(words) || PyTuple_GET_SIZE(words) != order)) {
+            PyErr_Format(PyExc_ValueError, "%d-gram rows must hold %d-tuples", order, order);
+            ok = false;
+        }
+        const char* s[ngram::kMaxOrder];
+        size_t      lens[ngram::kMaxOrder];
+        for (int w = 0; ok && w < order; w++) ok = utf8(PyTuple_GET_ITEM(words, w), s[w], lens[w]);
+        if (ok && !compiler.addNgram(order, s, lens, freq)) {
+            PyErr_SetString(PyExc_ValueError, "words must be non-empty, without NULs");
+            ok = false;
+        }
+    }
+    Py_DECREF(seq);
+    return ok;
+}
+
+PyObject* compileModel(PyObject*, PyObject* args) {
+    const char* path;
+    PyObject*   unigrams;
+    PyObject*   ngrams;
+    if (!PyArg_ParseTuple(args, "sOO", &path, &unigrams, &ngrams)) return nullptr;
+
+    ngram::Compiler compiler;
+    if (!addUnigrams(compiler, unigrams)) return nullptr;
+    PyObject* tables = PySequence_Fast(ngrams, "ngrams must be a list");
+    if (!tables) return nullptr;
+    if (PySequence_Fast_GET_SIZE(tables) != ngram::kMaxOrder - 1) {
+        Py_DECREF(tables);
+        PyErr_Format(PyExc_ValueError, "expected %d row lists (2..%d-grams)",
+                     ngram::kMaxOrder - 1, ngram::kMaxOrder);
+        return nullptr;
+    }
+    for (int order = 2; order <= ngram::kMaxOrder; order++) {
+        if (!addNgrams(compiler, order, PySequence_Fast_ITEMS(tables)[order - 2])) {
+            Py_DECREF(tables);
+            return nullptr;
+        }
+    }
+    Py_DECREF(tables);
+
+    const char* error;
+    Py_BEGIN_ALLOW_THREADS
+    error = compiler.write(path);
+    Py_END_ALLOW_THREADS
+    if (error) return PyErr_Format(PyExc_OSError, "%s: %s", path, error);
+    Py_RETURN_NONE;
+}
+
+// ── Loading ────────────────────────────────────────────────────────────────
+
+void releaseWords(EngineObject* self) {
+    if (!self->words) return;
+    size_t n = self->engine ? self->engine->model().vocabularySize() : 0;
+    for (size_t i = 0; i < n; i++) Py_XDECREF(self->words[i]);
+    PyMem_Free(self->words);
+    self->words = nullptr;
+}
+
+int engineInit(PyObject* obj, PyObject* args, PyObject* kwargs) {
+    auto* self = reinterpret_cast<EngineObject*>(obj);
+    static const char* kwlist[] = { "path", nullptr };
+    const char* path;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "s", const_cast<char**>(kwlist), &path))
+        return -1;
+
+    releaseWords(self);
+    delete self->engine;
+    delete self->result;
+    self->engine = new (std::nothrow) ngram::Engine();
+    self->result = new (std::nothrow) ngram::Suggestions();
+    if (!self->engine || !self->result) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    if (const char* error = self->engine->open(path)) {
+        PyErr_Format(PyExc_ValueError, "Model %s %s", path, error);
+        return -1;
+    }
+    size_t n = self->engine->model().vocabularySize();
+    self->words = static_cast<PyObject**>(PyMem_Calloc(n ? n : 1, sizeof(PyObject*)));
+    if (!self->words) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    return 0;
+}
+
+PyObject* wordObject(EngineObject* self, uint32_t id) {
+    PyObject*& w = self->words[id];
+    if (!w) {
+        const ngram::Model& m = self->engine->model();
+        w = PyUnicode_DecodeUTF8(m.word(id), static_cast<Py_ssize_t>(m.wordLength(id)), "strict");
+        if (!w) return nullptr;
+    }
+    Py_INCREF(w);
+    return w;
+}
+
+// ── Lookup ─────────────────────────────────────────────────────────────────
+
+PyObject* engineSuggest(PyObject* obj, PyObject* args) {
+    auto* self = reinterpret_cast<EngineObject*>(obj);
+    PyObject*  prefix;
+    PyObject*  context;
+    Py_ssize_t max_results;
+    if (!PyArg_ParseTuple(args, "UOn", &prefix, &context, &max_results)) return nullptr;
+    if (!self->words) {
+        PyErr_SetString(PyExc_RuntimeError, "Engine not initialised");
+        return nullptr;
+    }
+    if (max_results < 0) {
+        PyErr_SetString(PyExc_ValueError, "max_results must be >= 0");
+        return nullptr;
+    }
+    if (!PyList_Check(context)) {
+        PyErr_SetString(PyExc_TypeError, "context must be a list of words");
+        return nullptr;
+    }
+
+    // Only the last kMaxContext words can matter
+    Py_ssize_t  total = PyList_GET_SIZE(context);
+    Py_ssize_t  n     = total < kMaxContext ? total : kMaxContext;
+    const char* words[kMaxContext];
+    size_t      lens[kMaxContext];
+    for (Py_ssize_t i = 0; i < n; i++) {
+        PyObject* w = PyList_GET_ITEM(context, total - n + i);
+        Py_ssize_t len;
+        if (!PyUnicode_Check(w) || !(words[i] = PyUnicode_AsUTF8AndSize(w, &len))) {
+            if (!PyErr_Occurred()) PyErr_SetString(PyExc_TypeError, "context words must be str");
+            return nullptr;
+        }
+        lens[i] = static_cast<size_t>(len);
+    }
+    Py_ssize_t  plen;
+    const char* p = PyUnicode_AsUTF8AndSize(prefix, &plen);
+    if (!p) return nullptr;
+
+    ngram::Suggestions& r = *self->result;
+    self->engine->suggest(p, static_cast<size_t>(plen), words, lens, static_cast<size_t>(n),
+                          static_cast<size_t>(max_results), r);
+
+    PyObject* list = PyList_New(static_cast<Py_ssize_t>(r.words.size()));
+    if (!list) return nullptr;
+    for (size_t i = 0; i < r.words.size(); i++) {
+        PyObject* w = wordObject(self, r.words[i]);
+        if (!w) {
+            Py_DECREF(list);
+            return nullptr;
+        }
+        PyList_SET_ITEM(list, static_cast<Py_ssize_t>(i), w);
+    }
+
+    PyObject* label;
+    if (r.context > 0) {
+        PyObject* tail = PyList_GetSlice(context, total - r.context, total);
+        PyObject* sep  = tail ? PyUnicode_FromString(" ") : nullptr;
+        label = sep ? PyUnicode_Join(sep, tail) : nullptr;
+        Py_XDECREF(sep);
+        Py_XDECREF(tail);
+    } else if (r.context == 0 && plen > 0) {
+        Py_INCREF(prefix);
+        label = prefix;
+    } else {
+        label = PyTuple_GET_ITEM(self->levels, 0);      // "—"
+        Py_INCREF(label);
+    }
+    if (!label) {
+        Py_DECREF(list);
+        return nullptr;
+    }
+    PyObject* level = PyTuple_GET_ITEM(self->levels, r.level);
+    Py_INCREF(level);
+    return Py_BuildValue("(NNN)", list, level, label);
+}
+
+// ── Type ───────────────────────────────────────────────────────────────────
+
+PyObject* engineNew(PyTypeObject* type, PyObject*, PyObject*) {
+    auto* self = reinterpret_cast<EngineObject*>(type->tp_alloc(type, 0));
+    if (!self) return nullptr;
+    self->levels = Py_BuildValue("(ssssss)", "—", "1G", "2G", "3G", "4G", "5G");
+    if (!self->levels) {
+        Py_DECREF(self);
+        return nullptr;
+    }
+    return reinterpret_cast<PyObject*>(self);
+}
+
+void engineDealloc(PyObject* obj) {
+    auto* self = reinterpret_cast<EngineObject*>(obj);
+    releaseWords(self);
+    delete self->engine;
+    delete self->result;
+    Py_XDECREF(self->levels);
+    PyTypeObject* type = Py_TYPE(obj);     // a heap type: instances own a reference
+    type->tp_free(obj);
+    Py_DECREF(type);
+}
+
+PyObject* engineInfo(PyObject* obj, PyObject*) {
+    auto* self = reinterpret_cast<EngineObject*>(obj);
+    if (!self->words) {
+        PyErr_SetString(PyExc_RuntimeError, "Engine not initialised");
+        return nullptr;
+    }
+    const ngram::FileHeader& h = self->engine->model().header();
+    return Py_BuildValue("{s:I,s:I,s:K,s:I,s:I,s:(IIII),s:(IIII)}",
+        "version", h.version, "vocabulary", h.vocab_size,
+        "bytes", static_cast<unsigned long long>(h.file_size),
+        "trie_nodes", h.trie_node_count, "trie_top", h.trie_top_count,
+        "contexts", h.orders[2].context_count, h.orders[3].context_count,
+                    h.orders[4].context_count, h.orders[5].context_count,
+        "successors", h.orders[2].successor_count, h.orders[3].successor_count,
+                      h.orders[4].successor_count, h.orders[5].successor_count);
+}
+
+PyMethodDef kEngineMethods[] = {
+    { "suggest", engineSuggest, METH_VARARGS,
+      "suggest(prefix, context_words, max_results) -> (words, level, context)" },
+    { "info", engineInfo, METH_NOARGS, "Model format version and table sizes" },
+    { nullptr, nullptr, 0, nullptr },
+};
+
+PyType_Slot kEngineSlots[] = {
+    { Py_tp_doc,     const_cast<char*>("Engine(path): n-gram prediction with backoff over a compiled model") },
+    { Py_tp_new,     reinterpret_cast<void*>(engineNew) },
+    { Py_tp_init,    reinterpret_cast<void*>(engineInit) },
+    { Py_tp_dealloc, reinterpret_cast<void*>(engineDealloc) },
+    { Py_tp_methods, kEngineMethods },
+    { 0, nullptr },
+};
+
+PyType_Spec kEngineSpec = {
+    "_ngram.Engine", sizeof(EngineObject), 0, Py_TPFLAGS_DEFAULT, kEngineSlots,
+};
+
+PyMethodDef kModuleMethods[] = {
+    { "compile", compileModel, METH_VARARGS,
+      "compile(path, unigrams, ngrams): write a model file from CSV rows" },
+    { nullptr, nullptr, 0, nullptr },
+};
+
+PyModuleDef kModule = {
+    PyModuleDef_HEAD_INIT, "_ngram", "C++ n-gram word prediction for predictor.py", -1,
+    kModuleMethods, nullptr, nullptr, nullptr, nullptr,
+};
+
+} // namespace
+
+PyMODINIT_FUNC PyInit__ngram() {
+    PyObject* m = PyModule_Create(&kModule);
+    if (!m) return nullptr;
+    if (PyModule_AddIntConstant(m, "FORMAT_VERSION", ngram::kFormatVersion) < 0) {
+        Py_DECREF(m);
+        return nullptr;
+    }
+    PyObject* type = PyType_FromSpec(&kEngineSpec);
+    if (!type || PyModule_AddObject(m, "Engine", type) < 0) {
+        Py_XDECREF(type);
+        Py_DECREF(m);
+        return nullptr;
+    }
+    return m;
+}
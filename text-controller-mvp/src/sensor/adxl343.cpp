@@ -9,7 +9,7 @@
 #include <linux/i2c-dev.h>
 
 Adxl343::Adxl343(const char* i2c_device, int address)
-    : _device(i2c_device), _address(address), _fd(-1) {}
+    : _device(i2c_device), _address(address), _fd(-1), _errors(0) {}
 
 Adxl343::~Adxl343() {
     if (_fd >= 0) close(_fd);
@@ -41,15 +41,37 @@ bool Adxl343::init() {
     return true;
 }
 
-Vector3 Adxl343::readAccel() {
+bool Adxl343::readRaw(RawAccel& out) {
     uint8_t buf[6] = {};
-    readRegisters(REG_DATAX0, buf, 6);
+    bool ok = readRegisters(REG_DATAX0, buf, 6);
+    if (!ok) _errors++;
+
+    out.x = static_cast<int16_t>((buf[1] << 8) | buf[0]);
+    out.y = static_cast<int16_t>((buf[3] << 8) | buf[2]);
+    out.z = static_cast<int16_t>((buf[5] << 8) | buf[4]);
+    return ok;
+}
+
+bool Adxl343::reset() {
+    if (_fd >= 0) close(_fd);
+    _fd = -1;
+    return init();
+}
+
+bool Adxl343::standby() {
+    if (_fd < 0) return false;
+    // Clearing the Measure bit in POWER_CTL puts the part in standby
+    return writeRegister(REG_POWER_CTL, 0x00);
+}
 
-    int16_t x = static_cast<int16_t>((buf[1] << 8) | buf[0]);
-    int16_t y = static_cast<int16_t>((buf[3] << 8) | buf[2]);
-    int16_t z = static_cast<int16_t>((buf[5] << 8) | buf[4]);
+Vector3 Adxl343::readAccel() {
+    RawAccel r;
+    readRaw(r);
+    return toG(r);
+}
 
-    return { x / 256.0f, y / 256.0f, z / 256.0f };
+Vector3 Adxl343::toG(RawAccel r) {
+    return { r.x / 256.0f, r.y / 256.0f, r.z / 256.0f };
 }
 
 float Adxl343::getRoll(Vector3 a) {
@@ -7,20 +7,33 @@ struct Vector3 {
     float x, y, z;
 };
 
+// Raw 10-bit right-justified counts as read from DATAX0..DATAZ1
+struct RawAccel {
+    int16_t x, y, z;
+};
+
 class Adxl343 {
 public:
     explicit Adxl343(const char* i2c_device, int address);
     ~Adxl343();
 
     bool init();
+    bool reset();               // close and reopen the bus, then init()
+    bool standby();             // stop measuring; ~0.1 uA until next init()
+    bool readRaw(RawAccel& out);
     Vector3 readAccel();
-    float getRoll(Vector3 a);
-    float getPitch(Vector3 a);
+
+    uint64_t errorCount() const { return _errors; }
+
+    static Vector3 toG(RawAccel r);
+    static float getRoll(Vector3 a);
+    static float getPitch(Vector3 a);
 
 private:
     const char* _device;
     int         _address;
     int         _fd;            // open file descriptor for /dev/i2c-X
+    uint64_t    _errors;        // failed register transfers
 
     bool  writeRegister(uint8_t reg, uint8_t value);
     bool  readRegisters(uint8_t reg, uint8_t* buf, int len);
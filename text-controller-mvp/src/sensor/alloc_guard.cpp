@@ -0,0 +1,98 @@
+#include "alloc_guard.h"
+
+#ifdef SENSOR_ALLOC_DEBUG
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <execinfo.h>
+#include <unistd.h>
+
+// glibc's implementations, still exported under these names
+extern "C" {
+void* __libc_malloc(size_t);
+void* __libc_calloc(size_t, size_t);
+void* __libc_realloc(void*, size_t);
+void* __libc_memalign(size_t, size_t);
+void  __libc_free(void*);
+}
+
+namespace {
+
+std::atomic<uint64_t> g_count{0};
+std::atomic<uint64_t> g_bytes{0};
+std::atomic<uint64_t> g_after_arm{0};
+std::atomic<bool>     g_armed{false};
+std::atomic<bool>     g_trap{false};
+
+void trap(size_t size) {
+    static const char msg[] = "alloc_guard: heap allocation after warm-up, size ";
+    char num[24];
+    int  n = 0;
+    do { num[sizeof(num) - 1 - n++] = static_cast<char>('0' + size % 10); } while ((size /= 10) && n < 20);
+    (void)!write(STDERR_FILENO, msg, sizeof(msg) - 1);
+    (void)!write(STDERR_FILENO, num + sizeof(num) - n, static_cast<size_t>(n));
+    (void)!write(STDERR_FILENO, "\n", 1);
+
+    void* frames[32];
+    g_armed.store(false, std::memory_order_relaxed);    // backtrace may allocate
+    backtrace_symbols_fd(frames, backtrace(frames, 32), STDERR_FILENO);
+    abort();
+}
+
+inline void account(size_t size) {
+    g_count.fetch_add(1, std::memory_order_relaxed);
+    g_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (g_armed.load(std::memory_order_relaxed)) {
+        g_after_arm.fetch_add(1, std::memory_order_relaxed);
+        if (g_trap.load(std::memory_order_relaxed)) trap(size);
+    }
+}
+
+} // namespace
+
+extern "C" {
+
+void* malloc(size_t size)               { account(size);     return __libc_malloc(size); }
+void* calloc(size_t n, size_t size)     { account(n * size); return __libc_calloc(n, size); }
+void* realloc(void* p, size_t size)     { account(size);     return __libc_realloc(p, size); }
+void  free(void* p)                     { __libc_free(p); }
+void* memalign(size_t align, size_t size)      { account(size); return __libc_memalign(align, size); }
+void* aligned_alloc(size_t align, size_t size) { account(size); return __libc_memalign(align, size); }
+
+int posix_memalign(void** out, size_t align, size_t size) {
+    account(size);
+    void* p = __libc_memalign(align, size);
+    if (!p) return ENOMEM;
+    *out = p;
+    return 0;
+}
+
+} // extern "C"
+
+namespace alloc {
+
+Stats stats() {
+    return { g_count.load(std::memory_order_relaxed),
+             g_bytes.load(std::memory_order_relaxed),
+             g_after_arm.load(std::memory_order_relaxed) };
+}
+
+void arm(bool trap_on_alloc) {
+    // backtrace() loads libgcc lazily on first use; do that now, not in trap()
+    void* frame;
+    backtrace(&frame, 1);
+    g_after_arm.store(0, std::memory_order_relaxed);
+    g_trap.store(trap_on_alloc, std::memory_order_relaxed);
+    g_armed.store(true, std::memory_order_release);
+}
+
+void disarm() {
+    g_armed.store(false, std::memory_order_release);
+}
+
+} // namespace alloc
+
+#endif // SENSOR_ALLOC_DEBUG
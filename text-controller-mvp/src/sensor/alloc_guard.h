@@ -0,0 +1,39 @@
+#ifndef ALLOC_GUARD_H
+#define ALLOC_GUARD_H
+
+// Heap allocation accounting for the "no allocations while streaming"
+// rule. Built with SENSOR_ALLOC_DEBUG (make ALLOC_DEBUG=1), malloc and
+// friends are wrapped to count every call; operator new goes through
+// malloc in libstdc++, so it is counted too. After arm(true) any
+// allocation prints a backtrace and aborts. Without the flag everything
+// here compiles to nothing.
+
+#include <cstdint>
+
+namespace alloc {
+
+struct Stats {
+    uint64_t count;             // allocations since start
+    uint64_t bytes;
+    uint64_t after_arm;         // allocations since the last arm()
+};
+
+#ifdef SENSOR_ALLOC_DEBUG
+
+constexpr bool kEnabled = true;
+Stats stats();
+void  arm(bool trap);           // warm-up is over
+void  disarm();
+
+#else
+
+constexpr bool kEnabled = false;
+inline Stats stats() { return {}; }
+inline void  arm(bool) {}
+inline void  disarm() {}
+
+#endif
+
+} // namespace alloc
+
+#endif // ALLOC_GUARD_H
@@ -0,0 +1,33 @@
+#include "arena.h"
+
+#include <cstdio>
+#include <sys/mman.h>
+
+bool Arena::init(size_t capacity) {
+    release();
+    if (capacity == 0) return true;
+    void* m = mmap(nullptr, capacity, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (m == MAP_FAILED) {
+        perror("Failed to map arena");
+        return false;
+    }
+    _base     = static_cast<uint8_t*>(m);
+    _capacity = capacity;
+    _used     = 0;
+    return true;
+}
+
+void Arena::release() {
+    if (_base) munmap(_base, _capacity);
+    _base     = nullptr;
+    _capacity = 0;
+    _used     = 0;
+}
+
+void* Arena::alloc(size_t bytes, size_t align) {
+    size_t start = (_used + align - 1) & ~(align - 1);
+    if (!_base || start > _capacity || bytes > _capacity - start) return nullptr;
+    _used = start + bytes;
+    return _base + start;
+}
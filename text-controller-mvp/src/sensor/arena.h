@@ -0,0 +1,38 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Bump allocator over one anonymous mapping made up front. Nothing is
+// freed individually and it never grows, so structures carved from it
+// cost no heap traffic once a session is running. Under --rt the mapping
+// is locked and prefaulted by mlockall like everything else, so keep
+// capacities modest.
+class Arena {
+public:
+    Arena() : _base(nullptr), _capacity(0), _used(0) {}
+    ~Arena() { release(); }
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    bool init(size_t capacity);
+    void release();
+
+    // nullptr once exhausted
+    void* alloc(size_t bytes, size_t align);
+
+    template <typename T>
+    T* allocArray(size_t n) { return static_cast<T*>(alloc(n * sizeof(T), alignof(T))); }
+
+    void   reset() { _used = 0; }
+    size_t used()     const { return _used; }
+    size_t capacity() const { return _capacity; }
+
+private:
+    uint8_t* _base;
+    size_t   _capacity;
+    size_t   _used;
+};
+
+#endif // ARENA_H
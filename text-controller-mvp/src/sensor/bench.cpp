@@ -0,0 +1,358 @@
+// Benchmarks for the sensor pipeline, runnable without hardware.
+//
+//   make bench                         build, run, write bench.json
+//   ./sensor_bench [--out FILE] [--samples N] [--filter SUBSTR]
+//
+// Micro benchmarks time one stage over a ring of realistic inputs; the
+// macro benchmark replays a generated recording through every stage the
+// streaming loop runs (read, math, filter, format, record, output). Each
+// result is the median of several rounds, with heap allocations counted
+// across all rounds (the bench is always built with SENSOR_ALLOC_DEBUG).
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <sys/utsname.h>
+
+#include "adxl343.h"
+#include "alloc_guard.h"
+#include "clock.h"
+#include "control.h"
+#include "histogram.h"
+#include "output.h"
+#include "pipeline.h"
+#include "protocol.h"
+#include "recording.h"
+#include "sample_source.h"
+#include "stage_timer.h"
+
+namespace {
+
+constexpr int    kRounds  = 7;
+constexpr size_t kInputs  = 4096;   // power of two, fits in L1/L2
+
+struct Result {
+    const char* name;
+    double      ns_per_op;
+    uint64_t    ops;
+    uint64_t    allocations;
+};
+
+Result      g_results[32];
+int         g_count  = 0;
+const char* g_filter = nullptr;
+
+// Keep the optimiser from discarding a value or hoisting a loop body
+template <typename T>
+inline void keep(const T& v) { asm volatile("" : : "r,m"(v) : "memory"); }
+
+template <typename Fn>
+void bench(const char* name, uint64_t ops, Fn fn) {
+    if (g_filter && !strstr(name, g_filter)) return;
+
+    for (uint64_t i = 0; i < ops / 8; i++) fn(i);       // warm caches and branch predictors
+
+    double   rounds[kRounds];
+    uint64_t allocs = alloc::stats().count;
+    for (double& r : rounds) {
+        uint64_t t0 = rawClockNs();
+        for (uint64_t i = 0; i < ops; i++) fn(i);
+        r = static_cast<double>(rawClockNs() - t0) / ops;
+    }
+    allocs = alloc::stats().count - allocs;
+
+    // Median: robust to one round landing on a context switch
+    for (int i = 1; i < kRounds; i++)
+        for (int j = i; j > 0 && rounds[j] < rounds[j - 1]; j--) {
+            double t = rounds[j]; rounds[j] = rounds[j - 1]; rounds[j - 1] = t;
+        }
+
+    g_results[g_count++] = { name, rounds[kRounds / 2], ops, allocs };
+    fprintf(stderr, "  %-28s %10.1f ns/op %12.0f op/s %6llu allocs\n", name,
+            rounds[kRounds / 2], 1e9 / rounds[kRounds / 2],
+            static_cast<unsigned long long>(allocs));
+}
+
+// Inputs from the simulated source: realistic tilts and noise, not constants
+RawAccel g_raw[kInputs];
+Vector3  g_vec[kInputs];
+
+void makeInputs() {
+    SimulatedSource sim(7);
+    RawSample s;
+    for (size_t i = 0; i < kInputs; i++) {
+        sim.read(s);
+        g_raw[i] = s.accel;
+        g_vec[i] = Adxl343::toG(s.accel);
+    }
+}
+
+// Recording of `n` simulated samples at 62.5 Hz in a temp file
+bool makeRecording(char* path, size_t n) {
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return false;
+    }
+    close(fd);
+
+    rec::RecordingWriter w;
+    if (!w.open(path)) return false;
+    Pipeline p;
+    for (size_t i = 0; i < n; i++) {
+        const RawAccel& raw = g_raw[i % kInputs];
+        Orientation o = p.process(raw);
+        w.writeSample(1'000'000 + i * 16'000, raw, o.roll, o.pitch);
+    }
+    return w.close();
+}
+
+// ── Micro benchmarks ───────────────────────────────────────────────────────
+
+void microBenchmarks(uint64_t ops) {
+    constexpr size_t kMask = kInputs - 1;
+
+    bench("adxl343.toG", ops, [](uint64_t i) {
+        keep(Adxl343::toG(g_raw[i & kMask]));
+    });
+    bench("adxl343.getRoll", ops, [](uint64_t i) {
+        keep(Adxl343::getRoll(g_vec[i & kMask]));
+    });
+    bench("adxl343.getPitch", ops, [](uint64_t i) {
+        keep(Adxl343::getPitch(g_vec[i & kMask]));
+    });
+
+    Pipeline pipeline;
+    bench("pipeline.angles", ops, [&](uint64_t i) {
+        keep(pipeline.angles(g_raw[i & kMask]));
+    });
+    Orientation angles[kInputs];
+    for (size_t i = 0; i < kInputs; i++) angles[i] = pipeline.angles(g_raw[i]);
+    bench("pipeline.filter (EMA)", ops, [&](uint64_t i) {
+        keep(pipeline.filter(angles[i & kMask]));
+    });
+    bench("pipeline.process", ops, [&](uint64_t i) {
+        keep(pipeline.process(g_raw[i & kMask]));
+    });
+
+    SimulatedSource sim;
+    RawSample s;
+    bench("source.simulated.read", ops, [&](uint64_t) {
+        sim.read(s);
+        keep(s);
+    });
+
+    char line[OutputWriter::kSlotSize];
+    proto::Frame frame{};
+    bench("proto.formatFrame roll,pitch", ops, [&](uint64_t i) {
+        frame.roll  = angles[i & kMask].roll;
+        frame.pitch = angles[i & kMask].pitch;
+        keep(proto::formatFrame(line, sizeof(line), frame, proto::kDefaultFields));
+    });
+    bench("proto.formatFrame all", ops, [&](uint64_t i) {
+        frame.seq   = i;
+        frame.t_us  = i * 16'000;
+        frame.raw   = g_raw[i & kMask];
+        frame.roll  = angles[i & kMask].roll;
+        frame.pitch = angles[i & kMask].pitch;
+        keep(proto::formatFrame(line, sizeof(line), frame, proto::kAllFields));
+    });
+
+    rec::RecordingWriter w;
+    if (w.open("/dev/null")) {
+        bench("recording.writeSample", ops, [&](uint64_t i) {
+            w.writeSample(i * 16'000, g_raw[i & kMask], angles[i & kMask].roll,
+                          angles[i & kMask].pitch);
+        });
+        w.close();
+    }
+
+    // Replay and fuzz_recording decode; one op is one record
+    char rec_path[] = "/tmp/sensor_bench_XXXXXX";
+    rec::RecordingReader reader;
+    if (makeRecording(rec_path, kInputs) && reader.open(rec_path) && reader.blockCount()) {
+        size_t            block = 0;
+        rec::BlockDecoder dec   = reader.decoder(0);
+        rec::Record       r;
+        bench("recording.decode", ops, [&](uint64_t) {
+            while (!dec.next(r)) {
+                block = block + 1 < reader.blockCount() ? block + 1 : 0;
+                dec   = reader.decoder(block);
+            }
+            keep(r.t_us);
+        });
+    }
+    unlink(rec_path);
+
+    static const char* const kCommands[] = { "HEALTH", "FIELDS roll,pitch,t_us,seq", "CPU", "NOPE" };
+    bench("control.parseCommand", ops, [&](uint64_t i) {
+        const char* line = kCommands[i & 3];
+        Command     cmd;
+        const char* error;
+        keep(parseCommand(line, strlen(line), cmd, error));
+        keep(cmd);
+    });
+
+    Histogram h;
+    bench("histogram.record", ops, [&](uint64_t i) {
+        h.record((i * 2654435761u) & 0xFFFFF);
+    });
+    StageTimer stages;
+    bench("stageTimer.lap", ops, [&](uint64_t) {
+        stages.lap(proto::Read);
+    });
+}
+
+// ── Macro benchmark ────────────────────────────────────────────────────────
+
+struct Macro {
+    size_t   samples;
+    double   ns_per_sample;
+    double   samples_per_s;
+    uint64_t allocations;
+    uint64_t output_overruns;
+};
+
+bool macroBenchmark(size_t n, Macro& m) {
+    char path[] = "/tmp/sensor_bench_XXXXXX";
+    if (!makeRecording(path, n)) return false;
+
+    rec::RecordingReader reader;
+    bool opened = reader.open(path);
+    unlink(path);           // mapping stays valid
+    if (!opened) return false;
+
+    int null_fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+    OutputWriter out(null_fd);
+    out.setLossless(true);
+    rec::RecordingWriter recorder;
+    if (null_fd < 0 || !out.start(RealtimeConfig()) || !recorder.open("/dev/null")) return false;
+
+    ReplaySource source(reader);
+    source.seek(reader.startUs());
+    Pipeline     pipeline;
+    StageTimer   stages;
+    proto::Frame frame{};
+    char         line[OutputWriter::kSlotSize];
+    RawSample    s;
+    size_t       done = 0;
+
+    uint64_t allocs = alloc::stats().count;
+    uint64_t t0     = rawClockNs();
+    for (;;) {
+        stages.begin();
+        if (source.read(s) != ReadStatus::Ok) break;
+        stages.lap(proto::Read);
+        Orientation a = pipeline.angles(s.accel);
+        stages.lap(proto::Math);
+        Orientation o = pipeline.filter(a);
+        stages.lap(proto::Filter);
+        recorder.writeSample(s.t_us, s.accel, o.roll, o.pitch);
+        frame.seq++;
+        frame.t_us  = s.t_us;
+        frame.raw   = s.accel;
+        frame.roll  = o.roll;
+        frame.pitch = o.pitch;
+        size_t len = proto::formatFrame(line, sizeof(line), frame, proto::kDefaultFields);
+        out.push(line, len);
+        stages.lap(proto::Format);
+        out.flush();
+        stages.lap(proto::Flush);
+        stages.end(0);
+        done++;
+    }
+    out.stop();             // include draining the last lines
+    uint64_t elapsed = rawClockNs() - t0;
+
+    m.samples         = done;
+    m.ns_per_sample   = done ? static_cast<double>(elapsed) / done : 0;
+    m.samples_per_s   = elapsed ? done * 1e9 / elapsed : 0;
+    m.allocations     = alloc::stats().count - allocs;
+    m.output_overruns = out.overruns();
+    recorder.close();
+    close(null_fd);
+
+    fprintf(stderr, "  %-28s %10.1f ns/sample %9.0f samples/s %6llu allocs\n",
+            "replay→pipeline→output", m.ns_per_sample, m.samples_per_s,
+            static_cast<unsigned long long>(m.allocations));
+    stages.print(stderr);
+    return true;
+}
+
+// ── Report ─────────────────────────────────────────────────────────────────
+
+void writeJson(FILE* f, const Macro* macro) {
+    utsname u{};
+    uname(&u);
+    fprintf(f, "{\n  \"schema\": 1,\n  \"machine\": \"%s\",\n  \"kernel\": \"%s\",\n"
+               "  \"compiler\": \"%s\",\n  \"micro\": [\n", u.machine, u.release, __VERSION__);
+    for (int i = 0; i < g_count; i++) {
+        const Result& r = g_results[i];
+        fprintf(f, "    {\"name\": \"%s\", \"ns_per_op\": %.2f, \"ops_per_s\": %.0f,"
+                   " \"ops\": %llu, \"allocations\": %llu}%s\n",
+                r.name, r.ns_per_op, 1e9 / r.ns_per_op,
+                static_cast<unsigned long long>(r.ops),
+                static_cast<unsigned long long>(r.allocations),
+                i + 1 < g_count ? "," : "");
+    }
+    fprintf(f, "  ]");
+    if (macro) {
+        fprintf(f, ",\n  \"macro\": {\"name\": \"replay_pipeline_output\", \"samples\": %zu,"
+                   " \"ns_per_sample\": %.2f, \"samples_per_s\": %.0f, \"allocations\": %llu,"
+                   " \"output_overruns\": %llu}",
+                macro->samples, macro->ns_per_sample, macro->samples_per_s,
+                static_cast<unsigned long long>(macro->allocations),
+                static_cast<unsigned long long>(macro->output_overruns));
+    }
+    fprintf(f, "\n}\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* out_path = nullptr;
+    size_t      samples  = 1'000'000;
+
+    static const option longopts[] = {
+        { "out",     required_argument, nullptr, 'o' },
+        { "samples", required_argument, nullptr, 'n' },
+        { "filter",  required_argument, nullptr, 'f' },
+        { nullptr, 0, nullptr, 0 },
+    };
+    int c;
+    while ((c = getopt_long(argc, argv, "", longopts, nullptr)) != -1) {
+        switch (c) {
+        case 'o': out_path = optarg;                                   break;
+        case 'n': samples  = static_cast<size_t>(atoll(optarg));       break;
+        case 'f': g_filter = optarg;                                   break;
+        default:
+            fprintf(stderr, "Usage: %s [--out FILE] [--samples N] [--filter SUBSTR]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    makeInputs();
+    fprintf(stderr, "Micro benchmarks (median of %d rounds):\n", kRounds);
+    microBenchmarks(1'000'000);
+
+    Macro macro{};
+    bool  have_macro = false;
+    if (samples > 0 && (!g_filter || strstr("macro", g_filter))) {
+        fprintf(stderr, "Macro benchmark (%zu samples):\n", samples);
+        have_macro = macroBenchmark(samples, macro);
+        if (!have_macro) return 1;
+    }
+
+    FILE* f = out_path ? fopen(out_path, "w") : stdout;
+    if (!f) {
+        perror("Failed to open bench output");
+        return 1;
+    }
+    writeJson(f, have_macro ? &macro : nullptr);
+    if (f != stdout) fclose(f);
+    return 0;
+}
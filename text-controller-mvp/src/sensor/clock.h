@@ -0,0 +1,34 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <cstdint>
+#include <ctime>
+
+// All sensor timestamps are CLOCK_MONOTONIC microseconds.
+inline uint64_t monotonicNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000ull + ts.tv_nsec;
+}
+
+inline uint64_t monotonicUs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1'000'000ull + ts.tv_nsec / 1'000;
+}
+
+// Not slewed by NTP: for measuring short intervals, never for timestamps.
+// Served from the vDSO, so cheap enough to read several times per sample.
+inline uint64_t rawClockNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000ull + ts.tv_nsec;
+}
+
+inline uint64_t realtimeUs() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1'000'000ull + ts.tv_nsec / 1'000;
+}
+
+#endif // CLOCK_H
@@ -13,6 +13,37 @@
 #define REG_DATA_FORMAT 0x31
 #define REG_DATAX0      0x32
 
+// --- FILTER ---
+#define FILTER_ALPHA    0.2f            // EMA weight of the newest sample
+
+// --- RUNTIME CONFIG ---
+// Optional file overriding the values in this header; see runtime_config.h.
+// Build with `make STATIC_CONFIG=1` to compile these values in instead.
+#define CONFIG_PATH     "/etc/text-controller/sensor.conf"
+
+// --- SHUTDOWN / WARM RESTART ---
+// Calibration + filter state saved on clean exit, reused by --warm-start
+#define STATE_PATH          "/var/tmp/text-controller-sensor.state"
+#define WARM_START_MAX_AGE  600             // seconds; older state recalibrates
+#define SHUTDOWN_BUDGET_MS  500             // hard cap from signal to exit
+
+// --- WATCHDOG ---
+// No acquisition heartbeat for STALL_TIMEOUT_MS → #STALL frame; at
+// ×RESET_FACTOR the I2C fd is reopened; at ×EXIT_FACTOR the binary exits 3.
+#define STALL_TIMEOUT_MS    250
+#define STALL_RESET_FACTOR  4
+#define STALL_EXIT_FACTOR   8
+
+// --- TRACING ---
+// Flight recorder of loop, output and watchdog events, written here on
+// SIGUSR1 or the TRACE command; `sensor --trace-json PATH` converts it
+#define TRACE_PATH          "/var/tmp/text-controller-sensor.trace"
+
+// --- METRICS ---
+// Prometheus textfile written by --metrics PATH (and served on
+// --metrics-socket) every METRICS_PERIOD_MS
+#define METRICS_PERIOD_MS   10000
+
 // --- GESTURE TUNING ---
 #define TILT_THRESHOLD  0.25f
 #define NOD_THRESHOLD   0.25f
@@ -0,0 +1,90 @@
+#include "control.h"
+
+#include <cstring>
+
+static bool matchWord(const char*& p, const char* end, const char* word) {
+    size_t n = strlen(word);
+    if (static_cast<size_t>(end - p) < n || strncmp(p, word, n) != 0) return false;
+    if (p + n != end && p[n] != ' ') return false;
+    p += n;
+    while (p < end && *p == ' ') p++;
+    return true;
+}
+
+// Commands without arguments reject trailing text
+static bool noArgs(const char* p, const char* end, const char*& error) {
+    if (p == end) return true;
+    error = "unexpected_argument";
+    return false;
+}
+
+bool parseCommand(const char* line, size_t len, Command& out, const char*& error) {
+    const char* p   = line;
+    const char* end = line + len;
+    while (p < end && *p == ' ') p++;
+    while (end > p && (end[-1] == ' ' || end[-1] == '\r')) end--;
+
+    out = {};
+    error = nullptr;
+
+    if (matchWord(p, end, "HELLO"))  { out.type = CommandType::Hello;  return noArgs(p, end, error); }
+    if (matchWord(p, end, "HEALTH")) { out.type = CommandType::Health; return noArgs(p, end, error); }
+    if (matchWord(p, end, "CONFIG")) { out.type = CommandType::Config; return noArgs(p, end, error); }
+    if (matchWord(p, end, "RELOAD")) { out.type = CommandType::Reload; return noArgs(p, end, error); }
+    if (matchWord(p, end, "TRACE"))  { out.type = CommandType::Trace;  return noArgs(p, end, error); }
+    if (matchWord(p, end, "CPU"))    { out.type = CommandType::Cpu;    return noArgs(p, end, error); }
+    if (matchWord(p, end, "QUIT"))   { out.type = CommandType::Quit;   return noArgs(p, end, error); }
+    if (matchWord(p, end, "FIELDS")) {
+        out.type = CommandType::Fields;
+        char list[128];
+        size_t n = static_cast<size_t>(end - p);
+        if (n == 0 || n >= sizeof(list)) {
+            error = "bad_field_list";
+            return false;
+        }
+        memcpy(list, p, n);
+        list[n] = '\0';
+        if (!proto::parseFieldList(list, out.fields)) {
+            error = "unknown_field";
+            return false;
+        }
+        return true;
+    }
+
+    error = "unknown_command";
+    return false;
+}
+
+char* LineBuffer::writePtr() {
+    // Compact consumed bytes to the front before every read
+    if (_start > 0) {
+        memmove(_buf, _buf + _start, _len - _start);
+        _len  -= _start;
+        _start = 0;
+    }
+    // A full buffer with no newline can never complete: drop it
+    if (_len == kCapacity) {
+        _len      = 0;
+        _overflow = true;
+    }
+    return _buf + _len;
+}
+
+bool LineBuffer::nextLine(const char*& line, size_t& len) {
+    while (_start < _len) {
+        char* begin = _buf + _start;
+        char* nl    = static_cast<char*>(memchr(begin, '\n', _len - _start));
+        if (!nl) return false;
+
+        *nl    = '\0';
+        _start = static_cast<size_t>(nl - _buf) + 1;
+        if (_overflow) {        // tail of an over-long line
+            _overflow = false;
+            continue;
+        }
+        line = begin;
+        len  = static_cast<size_t>(nl - begin);
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,67 @@
+#ifndef CONTROL_H
+#define CONTROL_H
+
+// Control channel: newline-terminated text commands on stdin or a
+// subscriber socket.
+//
+//   HELLO               re-send the #HELLO handshake
+//   FIELDS a,b,c        change the data frame fields (re-sends #HELLO)
+//   HEALTH              send a #HEALTH frame now
+//   CONFIG              re-send the #CONFIG frame
+//   RELOAD              re-read the config file (see runtime_config.h)
+//   TRACE               dump the event trace, reply #TRACE path=... events=N
+//   CPU                 send a #CPU frame now
+//   QUIT                shut down
+//
+// Replies are meta frames: the frame asked for, #ACK cmd=NAME for FIELDS,
+// RELOAD and QUIT (FIELDS and RELOAD also send everyone the new #HELLO or
+// #CONFIG), or #ERROR cmd=NAME reason=...
+
+#include <cstddef>
+
+#include "protocol.h"
+
+enum class CommandType {
+    Hello,
+    Fields,
+    Health,
+    Config,
+    Reload,
+    Trace,
+    Cpu,
+    Quit,
+};
+
+struct Command {
+    CommandType      type;
+    proto::FieldMask fields;
+};
+
+// Parse one line (without the newline). Returns false for unknown or
+// malformed commands; `error` then points at a static reason string.
+bool parseCommand(const char* line, size_t len, Command& out, const char*& error);
+
+// Accumulates partial reads and hands out complete lines. Lines longer
+// than the buffer are discarded rather than split.
+class LineBuffer {
+public:
+    static constexpr size_t kCapacity = 512;
+
+    LineBuffer() : _len(0), _start(0), _overflow(false) {}
+
+    // Space for the next read(); commit() the bytes actually read.
+    char*  writePtr();
+    size_t writeSpace() const { return kCapacity - _len; }
+    void   commit(size_t n) { _len += n; }
+
+    // Next complete line, NUL-terminated in place, without the newline.
+    bool nextLine(const char*& line, size_t& len);
+
+private:
+    char   _buf[kCapacity + 1];
+    size_t _len;
+    size_t _start;
+    bool   _overflow;
+};
+
+#endif // CONTROL_H
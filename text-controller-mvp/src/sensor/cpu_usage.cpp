@@ -0,0 +1,138 @@
+#include "cpu_usage.h"
+#include "clock.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+namespace cpu {
+
+namespace {
+
+enum SlotState : int { Free, Alive, Exited };
+
+struct Slot {
+    std::atomic<int> state{Free};
+    clockid_t        clock;
+    long             tid;
+    char             name[16];
+    proto::CpuUsage  final;         // valid once Exited
+};
+
+Slot                  g_slots[proto::kMaxCpuThreads];
+std::atomic<uint32_t> g_claimed{0};
+std::atomic<uint64_t> g_start_ns{0};
+
+thread_local Slot* t_slot = nullptr;
+
+uint64_t clockNs(clockid_t clock) {
+    timespec ts;
+    if (clock_gettime(clock, &ts) != 0) return 0;
+    return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+uint64_t fieldAfter(const char* text, const char* key) {
+    const char* p = strstr(text, key);
+    return p ? strtoull(p + strlen(key), nullptr, 10) : 0;
+}
+
+// "voluntary_ctxt_switches:\t12\nnonvoluntary_ctxt_switches:\t3" from the
+// thread's status file. Opened per call, not kept: an fd held for a thread
+// could be closed under a reader and reused by an unrelated open().
+bool readSwitches(long tid, proto::CpuUsage& u) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/self/task/%ld/status", tid);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;       // exited meanwhile: switches read as 0
+    char buf[4096];
+    ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0) return false;
+    buf[n] = '\0';
+    u.voluntary   = fieldAfter(buf, "\nvoluntary_ctxt_switches:");
+    u.involuntary = fieldAfter(buf, "\nnonvoluntary_ctxt_switches:");
+    return true;
+}
+
+proto::CpuUsage fromRusage(const rusage& ru, uint64_t cpu_ns) {
+    return { cpu_ns, static_cast<uint64_t>(ru.ru_nvcsw), static_cast<uint64_t>(ru.ru_nivcsw) };
+}
+
+} // namespace
+
+bool attachThread(const char* name) {
+    if (t_slot) return true;
+    uint32_t i = g_claimed.fetch_add(1, std::memory_order_relaxed);
+    if (i >= proto::kMaxCpuThreads) return false;
+    if (i == 0) g_start_ns.store(monotonicNs(), std::memory_order_relaxed);
+
+    Slot& s = g_slots[i];
+    if (pthread_getcpuclockid(pthread_self(), &s.clock) != 0) s.clock = CLOCK_THREAD_CPUTIME_ID;
+    s.tid = static_cast<long>(syscall(SYS_gettid));
+    strncpy(s.name, name, sizeof(s.name) - 1);
+    s.name[sizeof(s.name) - 1] = '\0';
+    s.state.store(Alive, std::memory_order_release);
+    t_slot = &s;
+    return true;
+}
+
+void detachThread() {
+    Slot* s = t_slot;
+    if (!s) return;
+    rusage ru;
+    if (getrusage(RUSAGE_THREAD, &ru) != 0) ru = {};
+    s->final = fromRusage(ru, clockNs(CLOCK_THREAD_CPUTIME_ID));
+    s->state.store(Exited, std::memory_order_release);
+    t_slot = nullptr;
+}
+
+// A thread may exit between the state check and the reads; its clock and
+// status file then fail and the report shows zeros for it once, until it
+// is Exited.
+void collect(proto::CpuReport& r) {
+    r = {};
+    uint64_t start = g_start_ns.load(std::memory_order_relaxed);
+    r.uptime_ms = start ? (monotonicNs() - start) / 1'000'000 : 0;
+    rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) ru = {};
+    r.process = fromRusage(ru, clockNs(CLOCK_PROCESS_CPUTIME_ID));
+
+    for (Slot& s : g_slots) {
+        int state = s.state.load(std::memory_order_acquire);
+        if (state == Free) continue;
+        proto::CpuUsage u = {};
+        if (state == Exited) {
+            u = s.final;
+        } else {
+            u.cpu_ns = clockNs(s.clock);
+            readSwitches(s.tid, u);
+        }
+        r.name[r.threads]   = s.name;
+        r.thread[r.threads] = u;
+        r.threads++;
+    }
+}
+
+void print(FILE* out) {
+    proto::CpuReport r;
+    collect(r);
+    double total = r.process.cpu_ns ? static_cast<double>(r.process.cpu_ns) : 1.0;
+    fprintf(out, "CPU by thread since start:\n");
+    fprintf(out, "  %-8s %10s %7s %10s %10s\n", "thread", "ms", "share", "voluntary", "preempted");
+    for (size_t i = 0; i <= r.threads; i++) {
+        const char*            name = i < r.threads ? r.name[i] : "process";
+        const proto::CpuUsage& u    = i < r.threads ? r.thread[i] : r.process;
+        fprintf(out, "  %-8s %10.1f %6.1f%% %10llu %10llu\n", name, u.cpu_ns / 1e6,
+                100.0 * u.cpu_ns / total,
+                static_cast<unsigned long long>(u.voluntary),
+                static_cast<unsigned long long>(u.involuntary));
+    }
+}
+
+} // namespace cpu
@@ -0,0 +1,43 @@
+#ifndef CPU_USAGE_H
+#define CPU_USAGE_H
+
+// Per-thread CPU accounting: which of the sensor's threads costs battery.
+//
+// Each thread registers itself once with attachThread(). Any thread can
+// then collect() a snapshot of all of them:
+//   - CPU time from each thread's CPU-time clock (pthread_getcpuclockid),
+//     the clock the thread itself reads as CLOCK_THREAD_CPUTIME_ID;
+//   - voluntary and involuntary context switches from
+//     /proc/self/task/TID/status, opened and read by each collect().
+// A thread that detaches records its final totals from getrusage
+// (RUSAGE_THREAD), so they stay in the report after it exits.
+//
+// collect() uses no heap or FILE streams and costs one clock read and an
+// open/read/close of a small file per thread, so it is safe on the loop
+// thread. Nothing is sampled unless someone asks: attaching only notes
+// the thread's clock and tid.
+
+#include <cstdint>
+#include <cstdio>
+
+#include "protocol.h"
+
+namespace cpu {
+
+// Register the calling thread as `name` (at most 15 characters). False if
+// all proto::kMaxCpuThreads slots are taken.
+bool attachThread(const char* name);
+
+// Freeze the calling thread's totals; call just before it exits
+void detachThread();
+
+// Totals for the process and for every thread attached so far; uptime
+// counts from the first attach
+void collect(proto::CpuReport& r);
+
+// Each thread's share of the process, for the exit summary
+void print(FILE* out);
+
+} // namespace cpu
+
+#endif // CPU_USAGE_H
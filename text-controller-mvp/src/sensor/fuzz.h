@@ -0,0 +1,32 @@
+#ifndef FUZZ_H
+#define FUZZ_H
+
+// Fuzz targets for everything the sensor parses from outside: recordings
+// (--replay), control lines (stdin and sockets) and the config file.
+//
+// Each fuzz_*.cpp defines the libFuzzer entry point and builds as its own
+// binary (`make fuzz`). With clang the engine is libFuzzer; otherwise
+// fuzz_main.cpp stands in for it, running the corpus and then blind
+// mutations with the same command line:
+//
+//   ./fuzz_control fuzz_work/control fuzz_corpus/control -max_total_time=60
+//
+// Both engines run under ASan and UBSan. A target reports a logic error
+// (one that no sanitizer would see) with FUZZ_CHECK, which aborts.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+#define FUZZ_CHECK(cond)                                                        \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            abort();                                                            \
+        }                                                                       \
+    } while (0)
+
+#endif // FUZZ_H
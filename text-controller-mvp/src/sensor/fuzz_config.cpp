@@ -0,0 +1,30 @@
+// Fuzz target: the runtime config file parser.
+//
+// parseConfig either accepts the whole text, leaving every tunable in its
+// documented range, or rejects it with a "line N: ..." reason. An
+// accepted config must still format as a single #CONFIG line.
+
+#include "fuzz.h"
+#include "output.h"
+#include "runtime_config.h"
+
+#include <cstring>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    SensorConfig c = kDefaultConfig;
+    char err[128] = "";
+    if (!parseConfig(reinterpret_cast<const char*>(data), size, c, err, sizeof(err))) {
+        FUZZ_CHECK(strncmp(err, "line ", 5) == 0);
+        return 0;
+    }
+
+    FUZZ_CHECK(memchr(c.i2c_device, '\0', sizeof(c.i2c_device)) != nullptr);
+    FUZZ_CHECK(c.i2c_addr >= 0x03 && c.i2c_addr <= 0x77);
+    FUZZ_CHECK(c.filter_alpha > 0.0f && c.filter_alpha <= 1.0f);
+
+    char line[OutputWriter::kSlotSize];
+    size_t n = formatConfig(line, sizeof(line), c, "file");
+    FUZZ_CHECK(n > 0 && n < sizeof(line) - 1 && line[n - 1] == '\n');
+    FUZZ_CHECK(memchr(line, '\n', n - 1) == nullptr);
+    return 0;
+}
@@ -0,0 +1,54 @@
+// Fuzz target: the control channel, from raw bytes to commands.
+//
+// The input is split into reads the way a pipe or socket might deliver
+// it (the first byte picks the read size), pushed through LineBuffer and
+// every complete line parsed. An accepted FIELDS command must name a
+// valid, non-empty field set and still format a #HELLO; a rejected
+// command must say why.
+
+#include "control.h"
+#include "fuzz.h"
+#include "output.h"
+#include "protocol.h"
+
+#include <cstring>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size == 0) return 0;
+    size_t chunk = 1 + data[0] % 64;
+    data++;
+    size--;
+
+    LineBuffer buf;
+    char       hello[OutputWriter::kSlotSize];
+    for (size_t off = 0; off < size; ) {
+        char*  dst = buf.writePtr();
+        size_t n   = size - off;
+        if (n > chunk) n = chunk;
+        if (n > buf.writeSpace()) n = buf.writeSpace();
+        memcpy(dst, data + off, n);
+        buf.commit(n);
+        off += n;
+
+        const char* line;
+        size_t      len;
+        while (buf.nextLine(line, len)) {
+            FUZZ_CHECK(len < LineBuffer::kCapacity);
+            FUZZ_CHECK(line[len] == '\0');
+
+            Command     cmd;
+            const char* error;
+            if (!parseCommand(line, len, cmd, error)) {
+                FUZZ_CHECK(error != nullptr);
+                continue;
+            }
+            FUZZ_CHECK(error == nullptr);
+            if (cmd.type == CommandType::Fields) {
+                FUZZ_CHECK(cmd.fields != 0 && (cmd.fields & ~proto::kAllFields) == 0);
+                size_t h = proto::formatHello(hello, sizeof(hello), cmd.fields, 62.5, "fuzz", 1000);
+                FUZZ_CHECK(h > 0 && h < sizeof(hello) - 1 && hello[h - 1] == '\n');
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,286 @@
+// Stand-in fuzzing engine for machines without clang's libFuzzer.
+//
+//   ./fuzz_X [CORPUS_DIR|FILE ...] [-runs=N] [-max_total_time=SEC]
+//            [-max_len=BYTES] [-seed=N]
+//
+// Runs every corpus input once, then mutates random corpus entries (bit
+// flips, byte and word overwrites, inserts, erases, splices) until -runs
+// or -max_total_time is reached, or forever if neither is given. Other
+// -flags are accepted and ignored, so libFuzzer command lines work as is.
+//
+// There is no coverage feedback: this finds shallow bugs and keeps the
+// corpus passing, and libFuzzer is the tool for digging deeper. Throughput
+// (execs and input bytes per second) is printed as it goes, so a slow
+// path shows up in the numbers. On a crash the input is written to
+// crash-<hash> in the working directory.
+
+#include "clock.h"
+#include "fuzz.h"
+
+#include <csignal>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+extern "C" __attribute__((weak)) int LLVMFuzzerInitialize(int* argc, char*** argv);
+
+// Sanitizer reports end in abort(), so the crash handler saves the input
+extern "C" const char* __asan_default_options()  { return "abort_on_error=1"; }
+extern "C" const char* __ubsan_default_options() { return "abort_on_error=1:print_stacktrace=1"; }
+
+namespace {
+
+struct Input {
+    uint8_t* data;
+    size_t   size;
+};
+
+Input*   g_corpus     = nullptr;
+size_t   g_corpus_len = 0;
+size_t   g_corpus_cap = 0;
+
+// The input being run, for the crash handler
+const uint8_t* volatile g_current      = nullptr;
+volatile size_t         g_current_size = 0;
+
+uint64_t g_rng = 0x9E3779B97F4A7C15ull;
+
+uint64_t rnd() {
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 7;
+    g_rng ^= g_rng << 17;
+    return g_rng;
+}
+
+size_t rnd(size_t n) { return n ? static_cast<size_t>(rnd() % n) : 0; }
+
+// ── Crash reporting ────────────────────────────────────────────────────────
+
+// Async-signal-safe: no stdio, no allocation
+void saveCurrent() {
+    const uint8_t* data = g_current;
+    size_t         size = g_current_size;
+    if (!data && size) return;
+
+    uint64_t h = 0xcbf29ce484222325ull;     // FNV-1a names the file
+    for (size_t i = 0; i < size; i++) h = (h ^ data[i]) * 0x100000001b3ull;
+    char name[] = "crash-0000000000000000";
+    for (int i = 0; i < 16; i++) name[sizeof(name) - 2 - i] = "0123456789abcdef"[(h >> (4 * i)) & 0xF];
+
+    int fd = open(name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return;
+    for (size_t off = 0; off < size; ) {
+        ssize_t n = write(fd, data + off, size - off);
+        if (n <= 0) break;
+        off += static_cast<size_t>(n);
+    }
+    close(fd);
+    static const char msg[] = "==fuzz== input saved to ";
+    (void)!write(STDERR_FILENO, msg, sizeof(msg) - 1);
+    (void)!write(STDERR_FILENO, name, sizeof(name) - 1);
+    (void)!write(STDERR_FILENO, "\n", 1);
+}
+
+void onCrash(int sig) {
+    saveCurrent();
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+// ── Corpus ─────────────────────────────────────────────────────────────────
+
+void addInput(const uint8_t* data, size_t size) {
+    if (g_corpus_len == g_corpus_cap) {
+        g_corpus_cap = g_corpus_cap ? g_corpus_cap * 2 : 64;
+        g_corpus = static_cast<Input*>(realloc(g_corpus, g_corpus_cap * sizeof(Input)));
+        if (!g_corpus) abort();
+    }
+    uint8_t* copy = static_cast<uint8_t*>(malloc(size ? size : 1));
+    if (!copy) abort();
+    if (size) memcpy(copy, data, size);
+    g_corpus[g_corpus_len++] = { copy, size };
+}
+
+void loadFile(const char* path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) {
+        if (fd >= 0) close(fd);
+        return;
+    }
+    size_t   size = static_cast<size_t>(st.st_size);
+    uint8_t* buf  = static_cast<uint8_t*>(malloc(size ? size : 1));
+    if (!buf) abort();
+    size_t got = 0;
+    while (got < size) {
+        ssize_t n = read(fd, buf + got, size - got);
+        if (n <= 0) break;
+        got += static_cast<size_t>(n);
+    }
+    close(fd);
+    addInput(buf, got);
+    free(buf);
+}
+
+void loadPath(const char* path) {
+    DIR* dir = opendir(path);
+    if (!dir) {
+        loadFile(path);
+        return;
+    }
+    while (dirent* e = readdir(dir)) {
+        if (e->d_name[0] == '.') continue;
+        char file[4096];
+        snprintf(file, sizeof(file), "%s/%s", path, e->d_name);
+        loadFile(file);
+    }
+    closedir(dir);
+}
+
+// ── Mutation ───────────────────────────────────────────────────────────────
+
+// Values that sit on boundaries: lengths, signs, varint continuation bits
+const uint64_t kInteresting[] = {
+    0, 1, 2, 0x7F, 0x80, 0xFF, 0x100, 0x7FFF, 0x8000, 0xFFFF, 4096, 4064,
+    0x7FFFFFFF, 0x80000000, 0xFFFFFFFF, 0x7FFFFFFFFFFFFFFFull, ~0ull,
+};
+
+size_t mutateOnce(uint8_t* buf, size_t size, size_t max_len) {
+    switch (rnd(8)) {
+    case 0:                                         // flip a bit
+        if (size) buf[rnd(size)] ^= static_cast<uint8_t>(1u << rnd(8));
+        break;
+    case 1:                                         // random byte
+        if (size) buf[rnd(size)] = static_cast<uint8_t>(rnd());
+        break;
+    case 2: {                                       // boundary value, 1/2/4/8 bytes LE
+        size_t   width = size_t(1) << rnd(4);
+        uint64_t v     = kInteresting[rnd(sizeof(kInteresting) / sizeof(kInteresting[0]))];
+        if (size >= width) memcpy(buf + rnd(size - width + 1), &v, width);
+        break;
+    }
+    case 3: {                                       // insert random bytes
+        size_t n = 1 + rnd(8);
+        if (size + n > max_len) break;
+        size_t at = rnd(size + 1);
+        memmove(buf + at + n, buf + at, size - at);
+        for (size_t i = 0; i < n; i++) buf[at + i] = static_cast<uint8_t>(rnd());
+        size += n;
+        break;
+    }
+    case 4: {                                       // erase a range
+        if (!size) break;
+        size_t at = rnd(size);
+        size_t n  = 1 + rnd(size - at < 16 ? size - at : 16);
+        memmove(buf + at, buf + at + n, size - at - n);
+        size -= n;
+        break;
+    }
+    case 5: {                                       // copy a chunk over another
+        if (size < 2) break;
+        size_t from = rnd(size), to = rnd(size);
+        size_t n    = 1 + rnd(size - (from > to ? from : to));
+        memmove(buf + to, buf + from, n);
+        break;
+    }
+    case 6: {                                       // splice in another input's tail
+        const Input& other = g_corpus[rnd(g_corpus_len)];
+        size_t at   = rnd(size + 1);
+        size_t from = rnd(other.size + 1);
+        size_t n    = other.size - from;
+        if (at + n > max_len) n = max_len - at;
+        memcpy(buf + at, other.data + from, n);
+        size = at + n;
+        break;
+    }
+    default:                                        // truncate
+        size = rnd(size + 1);
+        break;
+    }
+    return size;
+}
+
+bool flagValue(const char* arg, const char* name, long long& out) {
+    size_t n = strlen(name);
+    if (strncmp(arg, name, n) != 0 || arg[n] != '=') return false;
+    out = atoll(arg + n + 1);
+    return true;
+}
+
+void report(const char* what, uint64_t runs, uint64_t bytes, uint64_t start_ns) {
+    double secs = (monotonicNs() - start_ns) / 1e9;
+    if (secs <= 0) secs = 1e-9;
+    fprintf(stderr, "#%llu\t%s exec/s: %.0f MB/s: %.1f avg_len: %.0f corpus: %zu\n",
+            static_cast<unsigned long long>(runs), what, runs / secs, bytes / secs / 1e6,
+            runs ? static_cast<double>(bytes) / runs : 0.0, g_corpus_len);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (LLVMFuzzerInitialize) LLVMFuzzerInitialize(&argc, &argv);
+
+    long long runs = -1, max_time = 0, max_len = 0, seed = 0;
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        if (a[0] != '-') {
+            loadPath(a);
+        } else if (!flagValue(a, "-runs", runs) && !flagValue(a, "-max_total_time", max_time)
+                && !flagValue(a, "-max_len", max_len) && !flagValue(a, "-seed", seed)) {
+            fprintf(stderr, "==fuzz== ignoring %s\n", a);
+        }
+    }
+    if (g_corpus_len == 0) addInput(nullptr, 0);
+    for (size_t i = 0; i < g_corpus_len; i++)
+        if (!max_len || g_corpus[i].size > static_cast<size_t>(max_len)) max_len = g_corpus[i].size;
+    if (max_len < 64) max_len = 64;
+    g_rng ^= seed ? static_cast<uint64_t>(seed) : monotonicNs();
+
+    const int crash_signals[] = { SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT };
+    for (int sig : crash_signals) signal(sig, onCrash);
+
+    uint8_t* buf = static_cast<uint8_t*>(malloc(static_cast<size_t>(max_len)));
+    if (!buf) return 1;
+    uint64_t start = monotonicNs();
+    uint64_t done = 0, bytes = 0;
+
+    // Each input runs from its own exact-size copy, so ASan sees overreads
+    for (size_t i = 0; i < g_corpus_len && (runs < 0 || done < static_cast<uint64_t>(runs)); i++, done++) {
+        const Input& in = g_corpus[i];
+        g_current      = in.data;
+        g_current_size = in.size;
+        LLVMFuzzerTestOneInput(in.data, in.size);
+        bytes += in.size;
+    }
+    report("INITED", done, bytes, start);
+
+    uint64_t deadline = max_time > 0 ? start + static_cast<uint64_t>(max_time) * 1'000'000'000ull : 0;
+    uint64_t next_report = 1024;
+    while (runs < 0 || done < static_cast<uint64_t>(runs)) {
+        if (deadline && (done & 255) == 0 && monotonicNs() >= deadline) break;
+
+        const Input& base = g_corpus[rnd(g_corpus_len)];
+        size_t size = base.size < static_cast<size_t>(max_len) ? base.size : static_cast<size_t>(max_len);
+        memcpy(buf, base.data, size);
+        for (size_t m = 1 + rnd(4); m > 0; m--) size = mutateOnce(buf, size, static_cast<size_t>(max_len));
+
+        uint8_t* exact = static_cast<uint8_t*>(malloc(size ? size : 1));
+        if (!exact) return 1;
+        memcpy(exact, buf, size);
+        g_current      = exact;
+        g_current_size = size;
+        LLVMFuzzerTestOneInput(exact, size);
+        free(exact);
+        bytes += size;
+
+        if (++done == next_report) {
+            report("pulse", done, bytes, start);
+            next_report *= 2;
+        }
+    }
+    report("DONE", done, bytes, start);
+    free(buf);
+    return 0;
+}
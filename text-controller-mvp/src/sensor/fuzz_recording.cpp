@@ -0,0 +1,64 @@
+// Fuzz target: a recording as --replay reads it, through to data frames.
+//
+// The input is a whole file (header, blocks, optional footer). Every
+// record in every block is decoded, then the samples go through the
+// replay path: ReplaySource, calibration, the pipeline and formatFrame.
+// Whatever the file holds, each frame must be one complete line with
+// one value per field.
+//
+// Seeds are short recorded sessions and their block-aligned prefixes
+// (the shape of a recording cut off by a power loss); see fuzz_seeds.sh.
+
+#include "fuzz.h"
+#include "output.h"
+#include "pipeline.h"
+#include "protocol.h"
+#include "recording.h"
+#include "sample_source.h"
+
+#include <cstring>
+
+namespace {
+
+constexpr int kCalibrationSamples = 50;     // as SensorApp
+constexpr int kMaxFrames          = 4096;   // bounds the work per input
+
+void checkFrame(const char* line, size_t len, size_t cap) {
+    FUZZ_CHECK(len > 0 && len < cap - 1);   // never truncated
+    FUZZ_CHECK(line[len - 1] == '\n');
+    FUZZ_CHECK(memchr(line, '\n', len - 1) == nullptr);
+    size_t commas = 0;
+    for (size_t i = 0; i < len; i++) commas += line[i] == ',';
+    FUZZ_CHECK(commas == proto::FieldCount - 1);
+}
+
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    rec::RecordingReader reader;
+    if (!reader.openBuffer(data, size)) return 0;
+
+    for (size_t b = 0; b < reader.blockCount(); b++) {
+        rec::BlockDecoder dec = reader.decoder(b);
+        rec::Record       r;
+        for (int n = 0; n < kMaxFrames && dec.next(r); n++)
+            FUZZ_CHECK(r.kind == rec::Kind::Sample || r.kind == rec::Kind::Event);
+    }
+
+    ReplaySource source(reader);
+    source.seek(reader.startUs());
+    Pipeline pipeline;
+    char     line[OutputWriter::kSlotSize];
+    RawSample s;
+    for (int n = 0; n < kMaxFrames && source.read(s) == ReadStatus::Ok; n++) {
+        if (n < kCalibrationSamples) {
+            pipeline.addCalibrationSample(s.accel);
+            if (n == kCalibrationSamples - 1) pipeline.finishCalibration();
+            continue;
+        }
+        Orientation o = pipeline.process(s.accel);
+        proto::Frame f = { static_cast<uint64_t>(n), s.t_us, s.accel, o.roll, o.pitch, s.t_us };
+        checkFrame(line, proto::formatFrame(line, sizeof(line), f, proto::kAllFields), sizeof(line));
+    }
+    return 0;
+}
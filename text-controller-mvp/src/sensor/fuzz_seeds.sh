@@ -0,0 +1,30 @@
+#!/bin/sh
+# Cut fuzz_recording seeds from recorded sessions into fuzz_corpus/recording.
+# With no arguments a 2 s session is recorded from the simulated source.
+# For each recording, two seeds:
+#   NAME-full   the whole file, if it is small enough to mutate (<64 KiB)
+#   NAME-cut    header and first block, no footer (as after a power loss)
+#   usage: ./fuzz_seeds.sh [recording ...]
+set -eu
+
+OUT=fuzz_corpus/recording
+HEADER=32
+BLOCK=4096
+mkdir -p "$OUT"
+
+if [ $# -eq 0 ]; then
+    TMP=$(mktemp -d)
+    trap 'rm -rf "$TMP"' EXIT INT TERM
+    ./sensor --simulate --state none --health-ms 0 --duration 2 \
+             --record "$TMP/simulated.rec" </dev/null >/dev/null 2>&1
+    set -- "$TMP/simulated.rec"
+fi
+
+for rec in "$@"; do
+    name=$(basename "$rec" .rec)
+    if [ "$(wc -c <"$rec")" -lt 65536 ]; then
+        cp "$rec" "$OUT/$name-full"
+    fi
+    head -c $((HEADER + BLOCK)) "$rec" >"$OUT/$name-cut"
+    echo "$OUT/$name-full $OUT/$name-cut"
+done
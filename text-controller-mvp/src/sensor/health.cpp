@@ -0,0 +1,51 @@
+#include "health.h"
+
+HealthMonitor::HealthMonitor(uint64_t period_us)
+    : _period_us(period_us), _start_us(0), _next_us(0),
+      _interval_start_us(0), _interval_samples(0) {}
+
+void HealthMonitor::start(uint64_t now_us) {
+    _start_us          = now_us;
+    _interval_start_us = now_us;
+    _next_us           = now_us + _period_us;
+    _interval_samples  = 0;
+    _loop.reset();
+    _jitter.reset();
+}
+
+proto::HealthReport HealthMonitor::collect(uint64_t now_us, const HealthCounters& c,
+                                           bool reset) {
+    proto::HealthReport h{};
+    h.uptime_ms  = (now_us - _start_us) / 1000;
+    h.samples    = c.samples.value();
+    h.dropped    = c.dropped.value();
+    h.i2c_errors = c.i2c_errors.value();
+    h.stalls     = c.stalls.value();
+
+    uint64_t elapsed = now_us - _interval_start_us;
+    if (elapsed > 0)
+        h.odr_hz = (h.samples - _interval_samples) * 1e6 / elapsed;
+    h.loop_p50_us = _loop.percentile(0.50) / 1e3;
+    h.loop_p99_us = _loop.percentile(0.99) / 1e3;
+    h.loop_max_us = _loop.max() / 1e3;
+    h.jitter_p50_us = _jitter.percentile(0.50) / 1e3;
+    h.jitter_p99_us = _jitter.percentile(0.99) / 1e3;
+    if (!reset) return h;
+
+    _interval_start_us = now_us;
+    _interval_samples  = h.samples;
+    _next_us          += _period_us;
+    if (_next_us <= now_us) _next_us = now_us + _period_us;
+    _loop.reset();
+    _jitter.reset();
+    return h;
+}
+
+void HealthGauges::publish(const proto::HealthReport& h) {
+    odr_hz.set(h.odr_hz);
+    loop_p50_s.set(h.loop_p50_us / 1e6);
+    loop_p99_s.set(h.loop_p99_us / 1e6);
+    loop_max_s.set(h.loop_max_us / 1e6);
+    jitter_p50_s.set(h.jitter_p50_us / 1e6);
+    jitter_p99_s.set(h.jitter_p99_us / 1e6);
+}
@@ -0,0 +1,57 @@
+#ifndef HEALTH_H
+#define HEALTH_H
+
+#include <cstdint>
+
+#include "histogram.h"
+#include "metrics.h"
+#include "protocol.h"
+
+// Written by the sampling loop, read by #HEALTH and the metrics exporter
+struct HealthCounters {
+    metrics::Counter samples;
+    metrics::Counter dropped;
+    metrics::Counter i2c_errors;
+    metrics::Counter stalls;        // watchdog stall events
+};
+
+// Last periodic #HEALTH values and the calibration in use, republished
+// for the metrics exporter
+struct HealthGauges {
+    metrics::Gauge odr_hz;
+    metrics::Gauge loop_p50_s, loop_p99_s, loop_max_s;
+    metrics::Gauge jitter_p50_s, jitter_p99_s;
+    metrics::Gauge calibration_warm;            // 1 = reused saved state
+    metrics::Gauge roll_offset, pitch_offset;   // rad
+    metrics::Gauge roll_spread, pitch_spread;   // rad, stddev while calibrating
+
+    void publish(const proto::HealthReport& h);
+};
+
+// Periodic #HEALTH frames: lets the consumer tell a still head (frames keep
+// coming) from a hung process or stalled bus (frames and health stop, or
+// health shows errors climbing while samples do not).
+class HealthMonitor {
+public:
+    explicit HealthMonitor(uint64_t period_us);
+
+    void start(uint64_t now_us);
+    void recordLoop(uint64_t work_ns)    { _loop.record(work_ns); }
+    void recordJitter(uint64_t late_ns)  { _jitter.record(late_ns); }
+    bool due(uint64_t now_us) const { return _period_us && now_us >= _next_us; }
+
+    // Report for the interval ending now. Periodic reports start the next
+    // interval; on-demand ones (reset = false) leave it running.
+    proto::HealthReport collect(uint64_t now_us, const HealthCounters& c, bool reset = true);
+
+private:
+    uint64_t  _period_us;
+    uint64_t  _start_us;
+    uint64_t  _next_us;
+    uint64_t  _interval_start_us;
+    uint64_t  _interval_samples;
+    Histogram _loop;
+    Histogram _jitter;
+};
+
+#endif // HEALTH_H
@@ -0,0 +1,61 @@
+#include "histogram.h"
+
+#include <cstring>
+
+void Histogram::reset() {
+    memset(_counts, 0, sizeof(_counts));
+    _total = 0;
+    _max   = 0;
+    _min   = UINT64_MAX;
+}
+
+void Histogram::merge(const Histogram& other) {
+    for (int i = 0; i < kBuckets; i++) _counts[i] += other._counts[i];
+    _total += other._total;
+    if (other._total) {
+        if (other._max > _max) _max = other._max;
+        if (other._min < _min) _min = other._min;
+    }
+}
+
+uint64_t Histogram::percentile(double q) const {
+    if (_total == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(q * (_total - 1)) + 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < kBuckets; i++) {
+        seen += _counts[i];
+        if (seen >= rank) {
+            uint64_t v = valueAt(i);
+            return v < _max ? v : _max;
+        }
+    }
+    return _max;
+}
+
+void Histogram::print(FILE* out, const char* title, double scale, const char* unit) const {
+    fprintf(out, "%s: n=%llu min=%.1f p50=%.1f p99=%.1f p99.9=%.1f max=%.1f %s\n",
+            title, static_cast<unsigned long long>(_total),
+            min() / scale, percentile(0.50) / scale, percentile(0.99) / scale,
+            percentile(0.999) / scale, max() / scale, unit);
+    if (_total == 0) return;
+
+    // One row per power of two keeps the dump readable
+    uint64_t octave[kMaxBits + 1] = {};
+    forEach([&](uint64_t upper, uint32_t count) {
+        octave[upper ? 64 - __builtin_clzll(upper) : 0] += count;
+    });
+
+    uint64_t peak = 0;
+    for (uint64_t n : octave) if (n > peak) peak = n;
+
+    uint64_t seen = 0;
+    for (int b = 0; b <= kMaxBits; b++) {
+        if (!octave[b]) continue;
+        seen += octave[b];
+        int bar = static_cast<int>(40.0 * octave[b] / peak + 0.5);
+        fprintf(out, "  < %10.1f %s %10llu %6.2f%% |%.*s\n",
+                static_cast<double>(1ull << b) / scale, unit,
+                static_cast<unsigned long long>(octave[b]), 100.0 * seen / _total,
+                bar, "########################################");
+    }
+}
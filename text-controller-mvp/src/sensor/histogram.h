@@ -0,0 +1,65 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <cstdint>
+#include <cstdio>
+
+// Fixed-memory log-linear histogram (HDR style). Values below 2^kSubBits
+// are exact; above that each power of two is split into 2^kSubBits buckets,
+// so any recorded value is reported within ~3%. No allocation, O(1) record.
+class Histogram {
+public:
+    static constexpr int kSubBits  = 5;
+    static constexpr int kMaxBits  = 40;    // ~18 minutes in ns
+    static constexpr int kSub      = 1 << kSubBits;
+    static constexpr int kBuckets  = (kMaxBits - kSubBits + 1) * kSub;
+
+    Histogram() { reset(); }
+
+    void record(uint64_t v) {
+        _counts[indexOf(v)]++;
+        _total++;
+        if (v > _max) _max = v;
+        if (v < _min) _min = v;
+    }
+
+    void     reset();
+    void     merge(const Histogram& other);
+    uint64_t percentile(double q) const;    // q in [0, 1]
+    uint64_t count() const { return _total; }
+    uint64_t max()   const { return _total ? _max : 0; }
+    uint64_t min()   const { return _total ? _min : 0; }
+
+    // Human-readable dump, values divided by `scale` and labelled `unit`
+    void print(FILE* out, const char* title, double scale, const char* unit) const;
+
+    // Iterate non-empty buckets: fn(upper_bound, count)
+    template <typename Fn>
+    void forEach(Fn fn) const {
+        for (int i = 0; i < kBuckets; i++)
+            if (_counts[i]) fn(valueAt(i), _counts[i]);
+    }
+
+    static int indexOf(uint64_t v) {
+        if (v >= (1ull << kMaxBits)) v = (1ull << kMaxBits) - 1;
+        if (v < kSub) return static_cast<int>(v);
+        int shift = 63 - __builtin_clzll(v) - kSubBits;
+        return shift * kSub + static_cast<int>(v >> shift);
+    }
+
+    // Highest value that maps to bucket idx
+    static uint64_t valueAt(int idx) {
+        if (idx < kSub) return static_cast<uint64_t>(idx);
+        int shift = idx / kSub - 1;
+        uint64_t sub = static_cast<uint64_t>(idx % kSub + kSub);
+        return ((sub + 1) << shift) - 1;
+    }
+
+private:
+    uint32_t _counts[kBuckets];
+    uint64_t _total;
+    uint64_t _max;
+    uint64_t _min;
+};
+
+#endif // HISTOGRAM_H
@@ -1,45 +1,145 @@
 #include <cstdio>
-#include <cmath>
-#include <unistd.h>     // usleep
-#include "config.h"
-#include "adxl343.h"
-
-static float roll_offset  = 0.0f;
-static float pitch_offset = 0.0f;
-static float filtered_roll  = 0.0f;
-static float filtered_pitch = 0.0f;
-
-int main() {
-    Adxl343 sensor(I2C_DEVICE, ADXL343_ADDR);
-    if (!sensor.init()) return 1;
-
-    // --- Calibration: 50-sample average ---
-    float sum_r = 0, sum_p = 0;
-    for (int i = 0; i < 50; i++) {
-        Vector3 v = sensor.readAccel();
-        sum_r += sensor.getRoll(v);
-        sum_p += sensor.getPitch(v);
-        usleep(20'000); // 20 ms
-    }
-    roll_offset  = sum_r / 50.0f;
-    pitch_offset = sum_p / 50.0f;
-    usleep(1'000'000); // 1 s settle
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
+#include "sensor_app.h"
+#include "trace.h"
 
-    // --- Main loop: stream roll,pitch to stdout ---
-    while (true) {
-        Vector3 v = sensor.readAccel();
-        float raw_roll  = sensor.getRoll(v)  - roll_offset;
-        float raw_pitch = sensor.getPitch(v) - pitch_offset;
+static constexpr int kDefaultRtPriority = 50;
 
-        filtered_roll  = filtered_roll  * 0.8f + raw_roll  * 0.2f;
-        filtered_pitch = filtered_pitch * 0.8f + raw_pitch * 0.2f;
+static void usage(const char* argv0) {
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  --record PATH        record raw + filtered samples to PATH\n"
+        "  --replay PATH        read samples from a recording instead of I2C\n"
+        "  --replay-speed X     replay rate multiplier (0 = unpaced, default 1)\n"
+        "  --replay-from SEC    start replay SEC seconds into the recording\n"
+        "  --fields LIST        data frame fields (default roll,pitch), any of\n"
+        "                       roll,pitch,t_us,seq,ax,ay,az,tx_us\n"
+        "  --health-ms MS       #HEALTH frame period (default 1000, 0 = off)\n"
+        "  --cpu-ms MS          #CPU per-thread usage period (default 0 = on request)\n"
+        "  --rate-hz HZ         live sampling rate (default 62.5)\n"
+        "  --catch-up POLICY    on missed deadlines: skip (default), burst, shift\n"
+        "  --simulate           synthetic head movement instead of I2C\n"
+        "  --duration SEC       exit after SEC seconds of streaming\n"
+        "  --rt[=PRIO]          SCHED_FIFO (default %d) with locked, prefaulted memory\n"
+        "  --cpu N              pin the acquisition thread to CPU N\n"
+        "  --socket PATH        also serve the stream on a Unix socket\n"
+        "  --config PATH        runtime config file (default %s)\n"
+        "  --state PATH         calibration state file (default %s, 'none' = off)\n"
+        "  --warm-start         reuse saved calibration if under %d s old\n"
+        "  --shutdown-ms MS     hard cap on shutdown time (default %d)\n"
+        "  --stall-ms MS        watchdog stall timeout (default %d, 0 = off)\n"
+        "  --trace PATH         event trace dump file (default %s)\n"
+        "  --trace-events N     trace ring size per thread (default %zu, 0 = off)\n"
+        "  --trace-json PATH    convert a trace dump to Chrome JSON on stdout and exit\n"
+        "  --metrics PATH       write Prometheus metrics to PATH (textfile collector)\n"
+        "  --metrics-socket PATH  also serve them on a Unix socket (plain or HTTP GET)\n"
+        "  --metrics-ms MS      metrics file period (default %d)\n"
+        "\n"
+        "Commands on stdin or the socket: HELLO, FIELDS a,b,c, HEALTH, CONFIG,\n"
+        "RELOAD, TRACE, CPU, QUIT\n"
+        "SIGUSR1 prints stage timings and dumps the event trace\n"
+        "Exit status: 0 normal, 1 setup failed, 2 bad arguments, %d stalled\n",
+        argv0, kDefaultRtPriority, CONFIG_PATH, STATE_PATH, WARM_START_MAX_AGE, SHUTDOWN_BUDGET_MS,
+        STALL_TIMEOUT_MS, TRACE_PATH, trace::kDefaultEvents, METRICS_PERIOD_MS, kExitStalled);
+}
 
-        // Same wire protocol as the Pico version
-        printf("%.4f,%.4f\n", filtered_roll, filtered_pitch);
-        fflush(stdout);     // essential — Python reads line-by-line
+static bool parseArgs(int argc, char** argv, AppOptions& opt, const char*& trace_json) {
+    static const option longopts[] = {
+        { "record",       required_argument, nullptr, 'r' },
+        { "replay",       required_argument, nullptr, 'p' },
+        { "replay-speed", required_argument, nullptr, 's' },
+        { "replay-from",  required_argument, nullptr, 'f' },
+        { "fields",       required_argument, nullptr, 'F' },
+        { "health-ms",    required_argument, nullptr, 'H' },
+        { "cpu-ms",       required_argument, nullptr, 'u' },
+        { "rate-hz",      required_argument, nullptr, 'R' },
+        { "catch-up",     required_argument, nullptr, 'C' },
+        { "simulate",     no_argument,       nullptr, 'S' },
+        { "duration",     required_argument, nullptr, 'd' },
+        { "rt",           optional_argument, nullptr, 'T' },
+        { "cpu",          required_argument, nullptr, 'c' },
+        { "socket",       required_argument, nullptr, 'U' },
+        { "config",       required_argument, nullptr, 'G' },
+        { "state",        required_argument, nullptr, 'P' },
+        { "warm-start",   no_argument,       nullptr, 'W' },
+        { "shutdown-ms",  required_argument, nullptr, 'X' },
+        { "stall-ms",     required_argument, nullptr, 'L' },
+        { "trace",        required_argument, nullptr, 'A' },
+        { "trace-events", required_argument, nullptr, 'E' },
+        { "trace-json",   required_argument, nullptr, 'J' },
+        { "metrics",      required_argument, nullptr, 'M' },
+        { "metrics-socket", required_argument, nullptr, 'K' },
+        { "metrics-ms",   required_argument, nullptr, 'm' },
+        { "help",         no_argument,       nullptr, 'h' },
+        { nullptr, 0, nullptr, 0 },
+    };
 
-        usleep(16'000); // ~60 Hz
+    int c;
+    while ((c = getopt_long(argc, argv, "h", longopts, nullptr)) != -1) {
+        switch (c) {
+        case 'r': opt.record_path   = optarg;         break;
+        case 'p': opt.replay_path   = optarg;         break;
+        case 's': opt.replay_speed  = atof(optarg);   break;
+        case 'f': opt.replay_from_s = atof(optarg);   break;
+        case 'F':
+            if (!proto::parseFieldList(optarg, opt.fields)) {
+                fprintf(stderr, "Unknown field in --fields '%s'\n", optarg);
+                return false;
+            }
+            break;
+        case 'H': opt.health_ms = static_cast<unsigned>(atoi(optarg)); break;
+        case 'u': opt.cpu_ms    = static_cast<unsigned>(atoi(optarg)); break;
+        case 'R': opt.rate_hz   = atof(optarg);   break;
+        case 'C':
+            if (!parseCatchUp(optarg, opt.catch_up)) {
+                fprintf(stderr, "Unknown catch-up policy '%s'\n", optarg);
+                return false;
+            }
+            break;
+        case 'S': opt.simulate   = true;           break;
+        case 'd': opt.duration_s = atof(optarg);   break;
+        case 'T':
+            opt.rt.fifo_priority = optarg ? atoi(optarg) : kDefaultRtPriority;
+            opt.rt.lock_memory   = true;
+            break;
+        case 'c': opt.rt.cpu = atoi(optarg);        break;
+        case 'U': opt.socket_path = optarg;         break;
+        case 'G':
+            opt.config_path     = optarg;
+            opt.config_required = true;
+            break;
+        case 'P': opt.state_path  = strcmp(optarg, "none") ? optarg : nullptr; break;
+        case 'W': opt.warm_start  = true;           break;
+        case 'L': opt.stall_ms    = static_cast<unsigned>(atoi(optarg)); break;
+        case 'X': opt.shutdown_ms = static_cast<unsigned>(atoi(optarg)); break;
+        case 'A': opt.trace_path   = optarg;        break;
+        case 'E': opt.trace_events = static_cast<size_t>(atoll(optarg)); break;
+        case 'J': trace_json       = optarg;        break;
+        case 'M': opt.metrics_path   = optarg;      break;
+        case 'K': opt.metrics_socket = optarg;      break;
+        case 'm': opt.metrics_ms     = static_cast<unsigned>(atoi(optarg)); break;
+        default:  usage(argv[0]);                     return false;
+        }
     }
+    return opt.replay_speed >= 0.0 && opt.replay_from_s >= 0.0
+        && opt.rate_hz > 0.0 && opt.rate_hz <= 3200.0      // ADXL343 max ODR
+        && opt.duration_s >= 0.0 && opt.shutdown_ms > 0 && opt.rt.fifo_priority >= 0 && opt.rt.fifo_priority <= 99;
+}
+
+int main(int argc, char** argv) {
+    AppOptions  opt;
+    const char* trace_json = nullptr;
+    if (!parseArgs(argc, argv, opt, trace_json)) return 2;
+    if (trace_json) return trace::toJson(trace_json, stdout) ? 0 : 1;
+
+    // Before any thread starts, so each can attach its ring
+    if (!trace::init(opt.trace_events)) return 1;
+
+    ConfigStore config;
+    if (!config.load(opt.config_path, opt.config_required)) return 2;
 
-    return 0;
+    SensorApp app(opt, config);
+    return app.run();
 }
@@ -0,0 +1,232 @@
+#include "metrics.h"
+#include "clock.h"
+#include "cpu_usage.h"
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+namespace metrics {
+
+static constexpr size_t kExporterStack = 64 * 1024;
+static constexpr int    kRequestWaitMs = 50;    // for an HTTP request line
+
+// ── Exposition ─────────────────────────────────────────────────────────────
+
+void Exposition::append(const char* fmt, ...) {
+    if (_truncated) return;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(_buf + _len, _cap - _len, fmt, ap);
+    va_end(ap);
+    if (n < 0 || static_cast<size_t>(n) >= _cap - _len) {
+        _truncated = true;
+        return;
+    }
+    _len += static_cast<size_t>(n);
+}
+
+void Exposition::family(const char* name, const char* type, const char* help) {
+    append("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+void Exposition::sample(const char* name, const char* labels, double value) {
+    if (labels) append("%s{%s} %.12g\n", name, labels, value);
+    else        append("%s %.12g\n", name, value);
+}
+
+void Exposition::sample(const char* name, const char* labels, uint64_t value) {
+    if (labels) append("%s{%s} %" PRIu64 "\n", name, labels, value);
+    else        append("%s %" PRIu64 "\n", name, value);
+}
+
+// ── Exporter ───────────────────────────────────────────────────────────────
+
+static bool writeAll(int fd, const char* p, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p   += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+static bool sendAll(int fd, const char* p, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);     // client may be gone
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p   += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+Exporter::Exporter()
+    : _textfile(nullptr), _socket_path{}, _period_ms(0), _rt(), _fn(nullptr), _ctx(nullptr),
+      _listen_fd(-1), _wake_fd(-1), _thread(), _running(false), _stop(false), _writes(0) {}
+
+Exporter::~Exporter() {
+    stop();
+}
+
+bool Exporter::start(const char* textfile, const char* socket_path, unsigned period_ms,
+                     const RealtimeConfig& rt, FormatFn fn, void* ctx) {
+    if (!textfile && !socket_path) return true;
+    _textfile  = textfile;
+    _period_ms = period_ms ? period_ms : 1;
+    _rt        = rt;
+    _fn        = fn;
+    _ctx       = ctx;
+
+    if (socket_path) {
+        sockaddr_un addr = {};
+        addr.sun_family = AF_UNIX;
+        if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+            fprintf(stderr, "Socket path too long: %s\n", socket_path);
+            return false;
+        }
+        strcpy(addr.sun_path, socket_path);
+        strcpy(_socket_path, socket_path);
+
+        _listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (_listen_fd < 0) {
+            perror("Failed to create metrics socket");
+            return false;
+        }
+        unlink(socket_path);    // stale socket from a previous run
+        if (bind(_listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0
+                || listen(_listen_fd, 4) < 0) {
+            perror("Failed to listen on metrics socket");
+            close(_listen_fd);
+            _listen_fd = -1;
+            return false;
+        }
+    }
+
+    _wake_fd = eventfd(0, EFD_CLOEXEC);
+    if (_wake_fd < 0) {
+        perror("Failed to create metrics eventfd");
+        return false;
+    }
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, kExporterStack);
+    int rc = pthread_create(&_thread, &attr, threadMain, this);
+    pthread_attr_destroy(&attr);
+    if (rc != 0) {
+        fprintf(stderr, "Failed to start metrics thread: %s\n", strerror(rc));
+        return false;
+    }
+    _running = true;
+    return true;
+}
+
+void Exporter::stop() {
+    if (_running) {
+        _stop.store(true, std::memory_order_release);
+        uint64_t one = 1;
+        (void)!write(_wake_fd, &one, sizeof(one));
+        pthread_join(_thread, nullptr);
+        _running = false;
+    }
+    if (_wake_fd >= 0) close(_wake_fd);
+    if (_listen_fd >= 0) {
+        close(_listen_fd);
+        unlink(_socket_path);
+    }
+    _wake_fd = _listen_fd = -1;
+}
+
+void* Exporter::threadMain(void* self) {
+    static_cast<Exporter*>(self)->run();
+    return nullptr;
+}
+
+void Exporter::run() {
+    demoteCurrentThread(_rt);
+    cpu::attachThread("metrics");
+
+    uint64_t period_ns = _period_ms * 1'000'000ull;
+    uint64_t next_ns   = monotonicNs();
+    while (!_stop.load(std::memory_order_acquire)) {
+        uint64_t now = monotonicNs();
+        if (_textfile && now >= next_ns) {
+            writeTextfile(snapshot());
+            next_ns = now + period_ns;
+        }
+
+        pollfd fds[2] = { { _wake_fd, POLLIN, 0 }, { _listen_fd, POLLIN, 0 } };
+        int timeout = _textfile ? static_cast<int>((next_ns - now + 999'999) / 1'000'000) : -1;
+        if (poll(fds, _listen_fd >= 0 ? 2 : 1, timeout) <= 0) continue;
+
+        if (fds[1].revents & POLLIN) {
+            int client = accept4(_listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (client >= 0) {
+                serve(client, snapshot());
+                close(client);
+            }
+        }
+    }
+    if (_textfile) writeTextfile(snapshot());   // final values, e.g. after a stall
+    cpu::detachThread();
+}
+
+size_t Exporter::snapshot() {
+    Exposition out(_buf, sizeof(_buf));
+    _fn(_ctx, out);
+    if (out.truncated()) fprintf(stderr, "Metrics exposition truncated at %zu bytes\n", out.length());
+    return out.length();
+}
+
+void Exporter::writeTextfile(size_t len) {
+    char tmp[256];
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", _textfile) >= static_cast<int>(sizeof(tmp))) return;
+
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        perror("Failed to write metrics file");
+        return;
+    }
+    bool ok = writeAll(fd, _buf, len);
+    if (close(fd) != 0 || !ok || rename(tmp, _textfile) != 0) {
+        perror("Failed to write metrics file");
+        unlink(tmp);
+        return;
+    }
+    _writes.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Bare HTTP when asked for it; otherwise just the text
+void Exporter::serve(int client, size_t len) {
+    char req[256];
+    ssize_t n = 0;
+    pollfd pfd = { client, POLLIN, 0 };
+    if (poll(&pfd, 1, kRequestWaitMs) > 0) n = recv(client, req, sizeof(req), MSG_DONTWAIT);
+
+    if (n >= 4 && memcmp(req, "GET ", 4) == 0) {
+        char head[160];
+        int h = snprintf(head, sizeof(head),
+                         "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                         "Content-Length: %zu\r\n\r\n", len);
+        if (!sendAll(client, head, static_cast<size_t>(h))) return;
+    }
+    sendAll(client, _buf, len);
+}
+
+} // namespace metrics
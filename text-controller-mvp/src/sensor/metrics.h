@@ -0,0 +1,110 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+// Fleet metrics in the Prometheus text exposition format.
+//
+// Counter and Gauge are single relaxed atomics: the sampling loop pays one
+// uncontended add or store per update and never sees the exporter. The
+// exporter thread wakes every period, formats a snapshot into a fixed
+// buffer and
+//   - rewrites a textfile-collector file atomically (PATH.tmp + rename), so
+//     node_exporter never reads a half-written file;
+//   - optionally answers connections on a Unix socket with the same text,
+//     as a bare HTTP/1.0 response when the client sends "GET ..." first
+//     (curl --unix-socket), or as plain text for socat and friends.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <pthread.h>
+
+#include "realtime.h"
+
+namespace metrics {
+
+class Counter {
+public:
+    void     inc(uint64_t n = 1) { _v.fetch_add(n, std::memory_order_relaxed); }
+    // For totals counted elsewhere (e.g. the I2C driver); must not go down
+    void     set(uint64_t v)     { _v.store(v, std::memory_order_relaxed); }
+    uint64_t value() const       { return _v.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> _v{0};
+};
+
+class Gauge {
+public:
+    void   set(double v)   { _v.store(v, std::memory_order_relaxed); }
+    double value() const   { return _v.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<double> _v{0.0};
+};
+
+// Appends exposition text to a caller-owned buffer; output past `cap` is
+// dropped and flagged rather than overflowing.
+class Exposition {
+public:
+    Exposition(char* buf, size_t cap) : _buf(buf), _cap(cap), _len(0), _truncated(false) {}
+
+    // "# HELP" and "# TYPE" lines; once per metric family
+    void family(const char* name, const char* type, const char* help);
+    // One sample; `labels` is the inside of {...}, or nullptr
+    void sample(const char* name, const char* labels, double value);
+    void sample(const char* name, const char* labels, uint64_t value);
+
+    size_t length()    const { return _len; }
+    bool   truncated() const { return _truncated; }
+
+private:
+    void append(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+    char*  _buf;
+    size_t _cap;
+    size_t _len;
+    bool   _truncated;
+};
+
+class Exporter {
+public:
+    static constexpr size_t kBufferSize = 8 * 1024;
+
+    // Fills `out` from the current metric values; runs on the exporter thread
+    using FormatFn = void (*)(void* ctx, Exposition& out);
+
+    Exporter();
+    ~Exporter();
+
+    // Either path may be nullptr; with both unset nothing starts.
+    bool start(const char* textfile, const char* socket_path, unsigned period_ms,
+               const RealtimeConfig& rt, FormatFn fn, void* ctx);
+    void stop();            // writes a final snapshot, then joins
+
+    uint64_t writes() const { return _writes.load(std::memory_order_relaxed); }
+
+private:
+    const char* _textfile;
+    char        _socket_path[108];
+    unsigned    _period_ms;
+    RealtimeConfig _rt;
+    FormatFn    _fn;
+    void*       _ctx;
+    int         _listen_fd;
+    int         _wake_fd;
+    pthread_t   _thread;
+    bool        _running;
+    std::atomic<bool>     _stop;
+    std::atomic<uint64_t> _writes;
+    char        _buf[kBufferSize];
+
+    static void* threadMain(void* self);
+    void   run();
+    size_t snapshot();
+    void   writeTextfile(size_t len);
+    void   serve(int client, size_t len);
+};
+
+} // namespace metrics
+
+#endif // METRICS_H
@@ -0,0 +1,146 @@
+#include "output.h"
+#include "cpu_usage.h"
+#include "trace.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+static constexpr size_t kWriterStack = 64 * 1024;
+
+static bool writeAll(int fd, const char* p, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p   += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+OutputWriter::OutputWriter(int fd)
+    : _fd(fd), _wake_fd(-1), _thread(), _running(false), _lossless(false), _rt(),
+      _head(0), _tail(0), _stop(false), _overruns(0),
+      _urgent_len(0) {}
+
+OutputWriter::~OutputWriter() {
+    stop();
+}
+
+bool OutputWriter::start(const RealtimeConfig& rt) {
+    _rt = rt;
+    _wake_fd = eventfd(0, EFD_CLOEXEC);
+    if (_wake_fd < 0) {
+        perror("Failed to create output eventfd");
+        return false;
+    }
+
+    // Small explicit stack: under mlockall the default 8 MB would be pinned
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, kWriterStack);
+    int rc = pthread_create(&_thread, &attr, threadMain, this);
+    pthread_attr_destroy(&attr);
+    if (rc != 0) {
+        fprintf(stderr, "Failed to start output thread: %s\n", strerror(rc));
+        return false;
+    }
+    _running = true;
+    return true;
+}
+
+void OutputWriter::stop() {
+    if (!_running) return;
+    _stop.store(true, std::memory_order_release);
+    flush();
+    pthread_join(_thread, nullptr);
+    _running = false;
+    close(_wake_fd);
+    _wake_fd = -1;
+}
+
+bool OutputWriter::push(const char* line, size_t len) {
+    size_t head = _head.load(std::memory_order_relaxed);
+    while (head - _tail.load(std::memory_order_acquire) >= kSlots) {
+        if (!_lossless || !_running) {
+            _overruns.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        flush();
+        sched_yield();
+    }
+
+    Slot& s = _slots[head % kSlots];
+    if (len > sizeof(s.data)) len = sizeof(s.data);
+    memcpy(s.data, line, len);
+    s.len = static_cast<uint32_t>(len);
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+bool OutputWriter::postUrgent(const char* line, size_t len) {
+    if (urgentPending()) return false;
+    if (len > sizeof(_urgent)) len = sizeof(_urgent);
+    memcpy(_urgent, line, len);
+    _urgent_len.store(static_cast<uint32_t>(len), std::memory_order_release);
+    flush();
+    return true;
+}
+
+void OutputWriter::flush() {
+    uint64_t one = 1;
+    if (_wake_fd >= 0) (void)!write(_wake_fd, &one, sizeof(one));
+}
+
+void* OutputWriter::threadMain(void* self) {
+    static_cast<OutputWriter*>(self)->run();
+    return nullptr;
+}
+
+void OutputWriter::run() {
+    demoteCurrentThread(_rt);
+    trace::attachThread("output");
+    cpu::attachThread("output");
+
+    for (;;) {
+        uint64_t n;
+        if (read(_wake_fd, &n, sizeof(n)) < 0 && errno != EINTR) break;
+        drain();
+        if (_stop.load(std::memory_order_acquire)) break;
+    }
+    drain();
+    cpu::detachThread();
+}
+
+// Copy everything queued into one buffer so a burst costs a single write()
+void OutputWriter::drain() {
+    trace::Span span(trace::Write);
+    char   buf[16 * 1024];
+    size_t len  = 0;
+    size_t tail = _tail.load(std::memory_order_relaxed);
+    size_t head = _head.load(std::memory_order_acquire);
+
+    while (tail != head) {
+        const Slot& s = _slots[tail % kSlots];
+        if (len + s.len > sizeof(buf)) {
+            writeAll(_fd, buf, len);
+            len = 0;
+        }
+        memcpy(buf + len, s.data, s.len);
+        len += s.len;
+        tail++;
+        _tail.store(tail, std::memory_order_release);
+    }
+    if (len > 0) writeAll(_fd, buf, len);
+
+    if (uint32_t n = _urgent_len.load(std::memory_order_acquire)) {
+        writeAll(_fd, _urgent, n);
+        _urgent_len.store(0, std::memory_order_release);
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <pthread.h>
+
+#include "realtime.h"
+
+// Moves stdout writes off the acquisition thread. The sampling loop copies
+// each line into a single-producer/single-consumer ring and never blocks;
+// a low-priority writer thread drains the ring into the pipe, so a slow
+// consumer costs dropped lines (counted) rather than sampling jitter.
+class OutputWriter {
+public:
+    static constexpr size_t kSlots    = 256;
+    static constexpr size_t kSlotSize = 256;
+
+    explicit OutputWriter(int fd);
+    ~OutputWriter();
+
+    bool start(const RealtimeConfig& rt);
+    void stop();                            // drains what is queued, then joins
+
+    bool push(const char* line, size_t len);    // false if the ring is full
+    void flush();                               // wake the writer
+
+    // Second producer for rare lines from other threads (watchdog): one
+    // line in flight at a time, false while the previous is unwritten.
+    bool postUrgent(const char* line, size_t len);
+    bool urgentPending() const { return _urgent_len.load(std::memory_order_acquire) != 0; }
+
+    // Offline use (replay): wait for ring space instead of dropping.
+    void setLossless(bool on) { _lossless = on; }
+
+    uint64_t overruns() const { return _overruns.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        uint32_t len;
+        char     data[kSlotSize - sizeof(uint32_t)];
+    };
+
+    int            _fd;
+    int            _wake_fd;        // eventfd
+    pthread_t      _thread;
+    bool           _running;
+    bool           _lossless;
+    RealtimeConfig _rt;
+
+    alignas(64) std::atomic<size_t>   _head;    // written by producer
+    alignas(64) std::atomic<size_t>   _tail;    // written by consumer
+    alignas(64) std::atomic<bool>     _stop;
+    std::atomic<uint64_t> _overruns;
+    std::atomic<uint32_t> _urgent_len;      // 0 = empty
+    char _urgent[kSlotSize];
+    Slot _slots[kSlots];
+
+    static void* threadMain(void* self);
+    void run();
+    void drain();
+};
+
+#endif // OUTPUT_H
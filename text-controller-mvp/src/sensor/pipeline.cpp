@@ -0,0 +1,52 @@
+#include "pipeline.h"
+
+#include <cmath>
+
+Pipeline::Pipeline(float alpha)
+    : _alpha(alpha), _sum_r(0), _sum_p(0), _sum_r2(0), _sum_p2(0), _cal_count(0),
+      _roll_offset(0), _pitch_offset(0), _roll_spread(0), _pitch_spread(0),
+      _filtered_roll(0), _filtered_pitch(0) {}
+
+void Pipeline::addCalibrationSample(const RawAccel& raw) {
+    Vector3 v = Adxl343::toG(raw);
+    float r = Adxl343::getRoll(v);
+    float p = Adxl343::getPitch(v);
+    _sum_r  += r;
+    _sum_p  += p;
+    _sum_r2 += r * r;
+    _sum_p2 += p * p;
+    _cal_count++;
+}
+
+void Pipeline::finishCalibration() {
+    if (_cal_count == 0) return;
+    _roll_offset  = _sum_r / _cal_count;
+    _pitch_offset = _sum_p / _cal_count;
+    _roll_spread  = sqrtf(fmaxf(_sum_r2 / _cal_count - _roll_offset * _roll_offset, 0.0f));
+    _pitch_spread = sqrtf(fmaxf(_sum_p2 / _cal_count - _pitch_offset * _pitch_offset, 0.0f));
+}
+
+Orientation Pipeline::angles(const RawAccel& raw) const {
+    Vector3 v = Adxl343::toG(raw);
+    return { Adxl343::getRoll(v)  - _roll_offset,
+             Adxl343::getPitch(v) - _pitch_offset };
+}
+
+Orientation Pipeline::filter(Orientation raw) {
+    _filtered_roll  = _filtered_roll  * (1.0f - _alpha) + raw.roll  * _alpha;
+    _filtered_pitch = _filtered_pitch * (1.0f - _alpha) + raw.pitch * _alpha;
+    return { _filtered_roll, _filtered_pitch };
+}
+
+Pipeline::State Pipeline::saveState() const {
+    return { _roll_offset, _pitch_offset, _filtered_roll, _filtered_pitch };
+}
+
+void Pipeline::restoreState(const State& s) {
+    _roll_offset    = s.roll_offset;
+    _pitch_offset   = s.pitch_offset;
+    _filtered_roll  = s.filtered_roll;
+    _filtered_pitch = s.filtered_pitch;
+    _roll_spread    = 0;
+    _pitch_spread   = 0;
+}
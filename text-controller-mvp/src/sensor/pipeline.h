@@ -0,0 +1,50 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "adxl343.h"
+#include "config.h"
+
+struct Orientation {
+    float roll, pitch;      // radians, calibrated and filtered
+};
+
+// Raw counts → roll/pitch → calibration offset → EMA low-pass.
+class Pipeline {
+public:
+    explicit Pipeline(float alpha = FILTER_ALPHA);
+
+    void  setAlpha(float alpha) { _alpha = alpha; }
+
+    void  addCalibrationSample(const RawAccel& raw);
+    void  finishCalibration();
+    float rollOffset()  const { return _roll_offset; }
+    float pitchOffset() const { return _pitch_offset; }
+    // Standard deviation of the calibration samples: a head held still
+    // gives a few mrad, a moving one much more. 0 after restoreState().
+    float rollSpread()  const { return _roll_spread; }
+    float pitchSpread() const { return _pitch_spread; }
+
+    // process() = filter(angles()); split so each half can be timed
+    Orientation process(const RawAccel& raw) { return filter(angles(raw)); }
+    Orientation angles(const RawAccel& raw) const;
+    Orientation filter(Orientation raw);
+
+    // Everything needed to resume filtering without recalibrating
+    struct State {
+        float roll_offset, pitch_offset;
+        float filtered_roll, filtered_pitch;
+    };
+    State saveState() const;
+    void  restoreState(const State& s);
+
+private:
+    float _alpha;
+    float _sum_r, _sum_p;
+    float _sum_r2, _sum_p2;
+    int   _cal_count;
+    float _roll_offset, _pitch_offset;
+    float _roll_spread, _pitch_spread;
+    float _filtered_roll, _filtered_pitch;
+};
+
+#endif // PIPELINE_H
@@ -0,0 +1,137 @@
+#include "protocol.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace proto {
+
+const FieldInfo kFields[FieldCount] = {
+    { "roll",  "rad" },
+    { "pitch", "rad" },
+    { "t_us",  "us"  },
+    { "seq",   "1"   },
+    { "ax",    "lsb" },
+    { "ay",    "lsb" },
+    { "az",    "lsb" },
+    { "tx_us", "us"  },
+};
+
+const char* const kStageNames[StageCount] = { "read", "math", "filter", "format", "flush" };
+
+bool parseFieldList(const char* list, FieldMask& out) {
+    FieldMask mask = 0;
+    const char* p = list;
+    while (*p) {
+        const char* end = strchr(p, ',');
+        size_t len = end ? static_cast<size_t>(end - p) : strlen(p);
+
+        int found = -1;
+        for (int i = 0; i < FieldCount; i++) {
+            if (strlen(kFields[i].name) == len && strncmp(kFields[i].name, p, len) == 0) {
+                found = i;
+                break;
+            }
+        }
+        if (found < 0) return false;
+        mask |= bit(static_cast<Field>(found));
+
+        if (!end) break;
+        p = end + 1;
+    }
+    if (mask == 0) return false;
+    out = mask;
+    return true;
+}
+
+// Append printf output to buf, tracking how much room is left.
+#define APPEND(...)                                                   \
+    do {                                                              \
+        int n_ = snprintf(buf + len, len < cap ? cap - len : 0,       \
+                          __VA_ARGS__);                               \
+        if (n_ > 0) len += static_cast<size_t>(n_);                   \
+    } while (0)
+
+static size_t appendList(char* buf, size_t cap, size_t len, FieldMask fields,
+                         bool units) {
+    bool first = true;
+    for (int i = 0; i < FieldCount; i++) {
+        if (!(fields & bit(static_cast<Field>(i)))) continue;
+        APPEND("%s%s", first ? "" : ",", units ? kFields[i].unit : kFields[i].name);
+        first = false;
+    }
+    return len;
+}
+
+size_t formatHello(char* buf, size_t cap, FieldMask fields,
+                   double rate_hz, const char* source, unsigned health_ms) {
+    size_t len = 0;
+    APPEND("#HELLO proto=%d fields=", kVersion);
+    len = appendList(buf, cap, len, fields, false);
+    APPEND(" units=");
+    len = appendList(buf, cap, len, fields, true);
+    APPEND(" rate_hz=%.1f source=%s health_ms=%u modes=live,replay,simulate,record available=",
+           rate_hz, source, health_ms);
+    len = appendList(buf, cap, len, kAllFields, false);
+    APPEND("\n");
+    return len < cap ? len : cap - 1;
+}
+
+size_t formatHealth(char* buf, size_t cap, const HealthReport& h) {
+    size_t len = 0;
+    APPEND("#HEALTH uptime_ms=%llu samples=%llu dropped=%llu i2c_errors=%llu stalls=%llu"
+           " odr_hz=%.1f loop_p50_us=%.1f loop_p99_us=%.1f loop_max_us=%.1f"
+           " jitter_p50_us=%.1f jitter_p99_us=%.1f\n",
+           static_cast<unsigned long long>(h.uptime_ms),
+           static_cast<unsigned long long>(h.samples),
+           static_cast<unsigned long long>(h.dropped),
+           static_cast<unsigned long long>(h.i2c_errors),
+           static_cast<unsigned long long>(h.stalls),
+           h.odr_hz, h.loop_p50_us, h.loop_p99_us, h.loop_max_us,
+           h.jitter_p50_us, h.jitter_p99_us);
+    return len < cap ? len : cap - 1;
+}
+
+size_t formatTiming(char* buf, size_t cap, const TimingReport& t) {
+    size_t len = 0;
+    APPEND("#TIMING");
+    for (int i = 0; i < StageCount; i++)
+        APPEND(" %s=%.2f/%.2f/%.2f", kStageNames[i],
+               t.stage[i].p50_us, t.stage[i].p99_us, t.stage[i].p999_us);
+    APPEND(" overruns=%llu\n", static_cast<unsigned long long>(t.overruns));
+    return len < cap ? len : cap - 1;
+}
+
+static size_t appendUsage(char* buf, size_t cap, size_t len, const char* name, const CpuUsage& u) {
+    APPEND(" %s=%.3f/%llu/%llu", name, u.cpu_ns / 1e6,
+           static_cast<unsigned long long>(u.voluntary),
+           static_cast<unsigned long long>(u.involuntary));
+    return len;
+}
+
+size_t formatCpu(char* buf, size_t cap, const CpuReport& r) {
+    size_t len = 0;
+    APPEND("#CPU uptime_ms=%llu", static_cast<unsigned long long>(r.uptime_ms));
+    len = appendUsage(buf, cap, len, "process", r.process);
+    for (size_t i = 0; i < r.threads; i++) len = appendUsage(buf, cap, len, r.name[i], r.thread[i]);
+    APPEND("\n");
+    return len < cap ? len : cap - 1;
+}
+
+size_t formatFrame(char* buf, size_t cap, const Frame& f, FieldMask fields) {
+    size_t len = 0;
+    const char* sep = "";
+    if (fields & bit(Roll))   { APPEND("%s%.4f", sep, f.roll);   sep = ","; }
+    if (fields & bit(Pitch))  { APPEND("%s%.4f", sep, f.pitch);  sep = ","; }
+    if (fields & bit(TimeUs)) { APPEND("%s%llu", sep, static_cast<unsigned long long>(f.t_us)); sep = ","; }
+    if (fields & bit(Seq))    { APPEND("%s%llu", sep, static_cast<unsigned long long>(f.seq));  sep = ","; }
+    if (fields & bit(RawX))   { APPEND("%s%d",   sep, f.raw.x);  sep = ","; }
+    if (fields & bit(RawY))   { APPEND("%s%d",   sep, f.raw.y);  sep = ","; }
+    if (fields & bit(RawZ))   { APPEND("%s%d",   sep, f.raw.z);  sep = ","; }
+    if (fields & bit(TxUs))   { APPEND("%s%llu", sep, static_cast<unsigned long long>(f.tx_us)); sep = ","; }
+    APPEND("\n");
+    return len < cap ? len : cap - 1;
+}
+
+#undef APPEND
+
+} // namespace proto
@@ -0,0 +1,132 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+// Line protocol on stdout.
+//
+//   Data frames:  comma-separated values, one sample per line, fields in
+//                 the order announced by the last #HELLO.
+//   Meta frames:  start with '#', then a frame type and key=value tokens:
+//                   #HELLO proto=1 fields=roll,pitch units=rad,rad ...
+//                   #HEALTH uptime_ms=... samples=... dropped=... ...
+//                   #TIMING read=p50/p99/p999 math=... overruns=...  (us)
+//                   #STALL level=warn|reset|exit|recovered stalled_ms=... stalls=...
+//                   #CONFIG source=file|defaults|static filter_alpha=... ...
+//                   #READY calibration=fresh|warm   (streaming starts)
+//                   #TRACE path=... events=N        (reply to TRACE)
+//                   #CPU uptime_ms=... process=ms/vol/invol loop=... output=...
+//                        (cumulative CPU time and context switches per thread)
+//                   #BYE reason=signal|quit|duration|end|stall shutdown_ms=...
+//
+// Consumers that only split on ',' and skip unparsable lines keep working:
+// the default field set is still "roll,pitch" at %.4f.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "adxl343.h"
+
+namespace proto {
+
+constexpr int kVersion = 1;
+
+enum Field : uint8_t {
+    Roll,
+    Pitch,
+    TimeUs,
+    Seq,
+    RawX,
+    RawY,
+    RawZ,
+    TxUs,       // CLOCK_MONOTONIC when the frame was formatted (latency tracing)
+    FieldCount
+};
+
+struct FieldInfo {
+    const char* name;
+    const char* unit;
+};
+
+extern const FieldInfo kFields[FieldCount];
+
+using FieldMask = uint32_t;
+constexpr FieldMask bit(Field f) { return 1u << f; }
+constexpr FieldMask kDefaultFields = bit(Roll) | bit(Pitch);
+constexpr FieldMask kAllFields     = (1u << FieldCount) - 1;
+
+// Everything a data frame can carry. Only the masked fields are formatted.
+struct Frame {
+    uint64_t seq;
+    uint64_t t_us;
+    RawAccel raw;
+    float    roll, pitch;
+    uint64_t tx_us;
+};
+
+struct HealthReport {
+    uint64_t uptime_ms;
+    uint64_t samples;           // frames emitted since start
+    uint64_t dropped;           // samples lost since start
+    uint64_t i2c_errors;
+    uint64_t stalls;
+    double   odr_hz;            // measured over the last interval
+    double   loop_p50_us;       // per-iteration work time, last interval
+    double   loop_p99_us;
+    double   loop_max_us;
+    double   jitter_p50_us;     // wake-up past deadline, last interval
+    double   jitter_p99_us;
+};
+
+// CPU time and context switches since the thread (or process) started.
+// Voluntary switches are wake-ups after blocking, the number that keeps a
+// battery unit out of its idle states; involuntary ones are preemptions.
+struct CpuUsage {
+    uint64_t cpu_ns;
+    uint64_t voluntary;
+    uint64_t involuntary;
+};
+
+constexpr size_t kMaxCpuThreads = 8;
+
+struct CpuReport {
+    uint64_t    uptime_ms;
+    CpuUsage    process;            // all threads, including exited ones
+    size_t      threads;
+    const char* name[kMaxCpuThreads];
+    CpuUsage    thread[kMaxCpuThreads];
+};
+
+// Stages of one streaming iteration, timed separately
+enum Stage : uint8_t {
+    Read,       // sample source (I2C transfer when live)
+    Math,       // raw counts → roll/pitch, minus calibration
+    Filter,     // EMA
+    Format,     // data frame, recording, health frames
+    Flush,      // wake the output thread
+    StageCount
+};
+
+extern const char* const kStageNames[StageCount];
+
+struct StagePercentiles {
+    double p50_us, p99_us, p999_us;
+};
+
+struct TimingReport {
+    StagePercentiles stage[StageCount];
+    uint64_t overruns;          // iterations longer than the sample period, since start
+};
+
+// Parse "roll,pitch,t_us" into a mask. Unknown names fail the whole list
+// silently; the caller reports it.
+bool parseFieldList(const char* list, FieldMask& out);
+
+size_t formatHello(char* buf, size_t cap, FieldMask fields,
+                   double rate_hz, const char* source, unsigned health_ms);
+size_t formatHealth(char* buf, size_t cap, const HealthReport& h);
+size_t formatTiming(char* buf, size_t cap, const TimingReport& t);
+size_t formatCpu(char* buf, size_t cap, const CpuReport& r);
+size_t formatFrame(char* buf, size_t cap, const Frame& f, FieldMask fields);
+
+} // namespace proto
+
+#endif // PROTOCOL_H
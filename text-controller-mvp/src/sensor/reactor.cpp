@@ -0,0 +1,72 @@
+#include "reactor.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <unistd.h>
+#include <sys/epoll.h>
+
+Reactor::Reactor() : _epfd(-1), _running(false) {
+    for (Watch& w : _watches) w = { -1, 0, nullptr, nullptr };
+}
+
+Reactor::~Reactor() {
+    if (_epfd >= 0) close(_epfd);
+}
+
+bool Reactor::init() {
+    _epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (_epfd < 0) {
+        perror("Failed to create epoll instance");
+        return false;
+    }
+    return true;
+}
+
+bool Reactor::add(int fd, uint32_t events, Callback cb, void* ctx) {
+    for (size_t i = 0; i < kMaxWatches; i++) {
+        Watch& w = _watches[i];
+        if (w.fd >= 0) continue;
+
+        epoll_event ev = {};
+        ev.events   = events;
+        ev.data.u64 = uint64_t(w.generation + 1) << 32 | i;
+        if (epoll_ctl(_epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            if (errno != EPERM) perror("epoll_ctl(ADD)");    // EPERM: not pollable
+            return false;
+        }
+        w = { fd, w.generation + 1, cb, ctx };
+        return true;
+    }
+    fprintf(stderr, "Reactor full, cannot watch fd %d\n", fd);
+    return false;
+}
+
+void Reactor::remove(int fd) {
+    for (Watch& w : _watches) {
+        if (w.fd != fd) continue;
+        epoll_ctl(_epfd, EPOLL_CTL_DEL, fd, nullptr);
+        w = { -1, w.generation, nullptr, nullptr };
+        return;
+    }
+}
+
+void Reactor::run() {
+    epoll_event events[kMaxWatches];
+    _running = true;
+
+    while (_running) {
+        int n = epoll_wait(_epfd, events, static_cast<int>(kMaxWatches), -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
+        }
+        for (int i = 0; i < n && _running; i++) {
+            const uint64_t data = events[i].data.u64;
+            const Watch&   w    = _watches[static_cast<uint32_t>(data)];
+            if (w.fd < 0 || w.generation != data >> 32) continue;   // removed by an earlier callback
+            w.cb(w.ctx, w.fd, events[i].events);
+        }
+    }
+    _running = false;
+}
@@ -0,0 +1,43 @@
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Minimal epoll reactor. Every source of work — sample timer, signals,
+// control input, subscriber sockets — is an fd with a callback, and the
+// loop sleeps in epoll_wait() until one of them is ready.
+class Reactor {
+public:
+    using Callback = void (*)(void* ctx, int fd, uint32_t events);
+
+    static constexpr size_t kMaxWatches = 32;
+
+    Reactor();
+    ~Reactor();
+
+    bool init();
+    bool add(int fd, uint32_t events, Callback cb, void* ctx);
+    void remove(int fd);
+
+    void run();                 // dispatch until stop()
+    void stop() { _running = false; }
+    bool running() const { return _running; }
+
+private:
+    // Events carry the slot index and the generation it was added under,
+    // so one queued for an fd that an earlier callback in the same batch
+    // removed is dropped even if the slot was reused since
+    struct Watch {
+        int      fd;
+        uint32_t generation;
+        Callback cb;
+        void*    ctx;
+    };
+
+    int   _epfd;
+    bool  _running;
+    Watch _watches[kMaxWatches];
+};
+
+#endif // REACTOR_H
@@ -0,0 +1,84 @@
+#include "realtime.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+static constexpr size_t kStackPrefault = 256 * 1024;
+static constexpr int    kDemotedNice   = 5;
+
+// Touch the stack we may use so later growth never page-faults.
+static void __attribute__((noinline)) prefaultStack() {
+    volatile unsigned char buf[kStackPrefault];
+    for (size_t i = 0; i < sizeof(buf); i += 4096) buf[i] = 0;
+}
+
+void enterRealtime(const RealtimeConfig& cfg) {
+    if (cfg.lock_memory) {
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0) {
+            prefaultStack();
+            fprintf(stderr, "RT: memory locked\n");
+        } else {
+            fprintf(stderr, "RT: mlockall failed (%s); continuing unlocked\n", strerror(errno));
+        }
+    }
+
+    if (cfg.cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cfg.cpu, &set);
+        int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (rc == 0)
+            fprintf(stderr, "RT: acquisition pinned to CPU %d\n", cfg.cpu);
+        else
+            fprintf(stderr, "RT: cannot pin to CPU %d (%s)\n", cfg.cpu, strerror(rc));
+    }
+
+    if (cfg.fifo_priority > 0) {
+        sched_param sp = {};
+        sp.sched_priority = cfg.fifo_priority;
+        int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp);
+        if (rc == 0)
+            fprintf(stderr, "RT: SCHED_FIFO priority %d\n", cfg.fifo_priority);
+        else
+            fprintf(stderr, "RT: SCHED_FIFO %d unavailable (%s); staying SCHED_OTHER\n",
+                    cfg.fifo_priority, strerror(rc));
+    }
+}
+
+static void avoidRealtimeCpu(const RealtimeConfig& cfg) {
+    if (cfg.cpu < 0) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    for (long i = 0; i < ncpu && i < CPU_SETSIZE; i++)
+        if (i != cfg.cpu) CPU_SET(i, &set);
+    if (CPU_COUNT(&set) > 0)
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+void demoteCurrentThread(const RealtimeConfig& cfg) {
+    sched_param sp = {};
+    pthread_setschedparam(pthread_self(), SCHED_OTHER, &sp);
+
+    // setpriority on a TID only affects that thread on Linux
+    pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+    setpriority(PRIO_PROCESS, static_cast<id_t>(tid), kDemotedNice);
+
+    avoidRealtimeCpu(cfg);
+}
+
+void superviseCurrentThread(const RealtimeConfig& cfg) {
+    if (cfg.fifo_priority > 0) {
+        sched_param sp = {};
+        sp.sched_priority = cfg.fifo_priority < 99 ? cfg.fifo_priority + 1 : 99;
+        pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp);
+    }
+    avoidRealtimeCpu(cfg);
+}
@@ -0,0 +1,25 @@
+#ifndef REALTIME_H
+#define REALTIME_H
+
+// Opt-in real-time execution for the acquisition thread. Every step is
+// best-effort: a missing capability (CAP_SYS_NICE, CAP_IPC_LOCK, rlimits)
+// is reported on stderr and the binary carries on without it.
+
+struct RealtimeConfig {
+    int  fifo_priority = 0;     // SCHED_FIFO 1..99, 0 = stay SCHED_OTHER
+    int  cpu           = -1;    // pin the acquisition thread, -1 = any
+    bool lock_memory   = false; // mlockall + prefault the stack
+};
+
+// Apply to the calling thread (the acquisition loop).
+void enterRealtime(const RealtimeConfig& cfg);
+
+// For output and housekeeping threads: SCHED_OTHER at a lower nice level,
+// kept off the acquisition CPU so they never compete with sampling.
+void demoteCurrentThread(const RealtimeConfig& cfg);
+
+// For supervisor threads that must preempt a runaway acquisition thread:
+// SCHED_FIFO one level above it (when it is real-time), off its CPU.
+void superviseCurrentThread(const RealtimeConfig& cfg);
+
+#endif // REALTIME_H
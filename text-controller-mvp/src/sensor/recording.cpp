@@ -0,0 +1,424 @@
+#include "recording.h"
+#include "clock.h"
+
+#include <algorithm>
+#include <type_traits>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace rec {
+
+// ── Varint helpers ─────────────────────────────────────────────────────────
+
+static inline uint64_t zigzag(int64_t v) {
+    return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+static inline int64_t unzigzag(uint64_t v) {
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+// Deltas from a corrupt block can be anything: accumulate with wrap-around
+// instead of signed overflow
+template <typename T>
+static inline T wrapAdd(T a, int64_t delta) {
+    using U = typename std::make_unsigned<T>::type;
+    return static_cast<T>(static_cast<U>(a) + static_cast<U>(delta));
+}
+
+static inline uint8_t* putVarint(uint8_t* p, uint64_t v) {
+    while (v >= 0x80) {
+        *p++ = static_cast<uint8_t>(v) | 0x80;
+        v >>= 7;
+    }
+    *p++ = static_cast<uint8_t>(v);
+    return p;
+}
+
+static inline bool getVarint(const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        uint8_t b = *p++;
+        v |= static_cast<uint64_t>(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+static bool writeAll(int fd, const void* data, size_t len) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p   += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Encode one record against `s`, advancing it. Returns bytes written.
+static size_t encode(const Record& r, DeltaState& s, uint8_t* out) {
+    int64_t dt  = static_cast<int64_t>(r.t_us - s.t_us);
+    int64_t dod = dt - s.dt_us;
+    s.t_us  = r.t_us;
+    s.dt_us = dt;
+
+    uint8_t* p = putVarint(out, zigzag(dod) << 1 | static_cast<uint64_t>(r.kind));
+    if (r.kind == Kind::Sample) {
+        p = putVarint(p, zigzag(int64_t(r.raw.x) - s.x));
+        p = putVarint(p, zigzag(int64_t(r.raw.y) - s.y));
+        p = putVarint(p, zigzag(int64_t(r.raw.z) - s.z));
+        p = putVarint(p, zigzag(int64_t(r.roll_q)  - s.roll_q));
+        p = putVarint(p, zigzag(int64_t(r.pitch_q) - s.pitch_q));
+        s.x = r.raw.x;
+        s.y = r.raw.y;
+        s.z = r.raw.z;
+        s.roll_q  = r.roll_q;
+        s.pitch_q = r.pitch_q;
+    } else {
+        p = putVarint(p, static_cast<uint64_t>(r.event));
+        p = putVarint(p, zigzag(r.value));
+    }
+    return static_cast<size_t>(p - out);
+}
+
+// ── RecordingWriter ────────────────────────────────────────────────────────
+
+RecordingWriter::RecordingWriter()
+    : _fd(-1), _offset(0), _block{}, _len(sizeof(BlockHeader)), _hdr{}, _state{},
+      _index(nullptr), _index_len(0), _index_cap(0) {}
+
+RecordingWriter::~RecordingWriter() {
+    close();
+}
+
+bool RecordingWriter::open(const char* path, size_t max_blocks) {
+    if (!_arena.init(max_blocks * sizeof(IndexEntry))) return false;
+    _index     = _arena.allocArray<IndexEntry>(max_blocks);
+    _index_len = 0;
+    _index_cap = _index ? max_blocks : 0;
+
+    _fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (_fd < 0) {
+        perror("Failed to open recording");
+        return false;
+    }
+
+    FileHeader fh{};
+    fh.magic              = kFileMagic;
+    fh.version            = kVersion;
+    fh.header_size        = sizeof(FileHeader);
+    fh.block_size         = kBlockSize;
+    fh.start_realtime_us  = realtimeUs();
+    fh.start_monotonic_us = monotonicUs();
+    if (!writeAll(_fd, &fh, sizeof(fh))) {
+        fail("Failed to write recording header");
+        return false;
+    }
+
+    _offset = sizeof(FileHeader);
+    _len    = sizeof(BlockHeader);
+    _hdr    = {};
+    return true;
+}
+
+void RecordingWriter::writeSample(uint64_t t_us, const RawAccel& raw, float roll, float pitch) {
+    Record r{};
+    r.kind    = Kind::Sample;
+    r.t_us    = t_us;
+    r.raw     = raw;
+    r.roll_q  = static_cast<int32_t>(lrintf(roll  * kAngleScale));
+    r.pitch_q = static_cast<int32_t>(lrintf(pitch * kAngleScale));
+    append(r);
+}
+
+void RecordingWriter::writeEvent(uint64_t t_us, EventType type, int64_t value) {
+    Record r{};
+    r.kind  = Kind::Event;
+    r.t_us  = t_us;
+    r.event = type;
+    r.value = value;
+    append(r);
+}
+
+void RecordingWriter::append(const Record& r) {
+    if (_fd < 0) return;
+
+    if (_hdr.count == 0) {
+        _state = {};
+        _state.t_us    = r.t_us;
+        _hdr.first_t_us = r.t_us;
+    }
+
+    uint8_t    tmp[48];
+    DeltaState next = _state;
+    size_t     n    = encode(r, next, tmp);
+
+    if (_len + n > kBlockSize) {
+        if (!flushBlock()) return;
+        _state = {};
+        _state.t_us     = r.t_us;
+        _hdr.first_t_us = r.t_us;
+        next = _state;
+        n    = encode(r, next, tmp);
+    }
+
+    memcpy(_block + _len, tmp, n);
+    _len   += n;
+    _state  = next;
+    _hdr.count++;
+    _hdr.last_t_us = r.t_us;
+}
+
+bool RecordingWriter::flushBlock() {
+    _hdr.magic       = kBlockMagic;
+    _hdr.payload_len = static_cast<uint32_t>(_len - sizeof(BlockHeader));
+    memcpy(_block, &_hdr, sizeof(_hdr));
+    memset(_block + _len, 0, kBlockSize - _len);
+
+    if (!writeAll(_fd, _block, kBlockSize)) {
+        fail("Failed to write recording block");
+        return false;
+    }
+
+    if (_index_len < _index_cap) {
+        _index[_index_len++] = { _offset, _hdr.first_t_us, _hdr.last_t_us, _hdr.count, 0 };
+    } else if (_index_cap > 0) {
+        fprintf(stderr, "Recording index full after %zu blocks; file will need a scan\n",
+                _index_cap);
+        _index_cap = 0;     // report once; close() skips the footer
+    }
+    _offset += kBlockSize;
+    _len     = sizeof(BlockHeader);
+    _hdr     = {};
+    return true;
+}
+
+bool RecordingWriter::close() {
+    if (_fd < 0) return false;
+
+    if (_hdr.count > 0 && !flushBlock()) return false;
+
+    if (_index_cap > 0) {
+        Trailer tr{};
+        tr.index_offset = _offset;
+        tr.entry_count  = static_cast<uint32_t>(_index_len);
+        tr.magic        = kIndexMagic;
+
+        bool ok = writeAll(_fd, _index, _index_len * sizeof(IndexEntry))
+               && writeAll(_fd, &tr, sizeof(tr));
+        if (!ok) {
+            fail("Failed to write recording index");
+            return false;
+        }
+    }
+
+    ::close(_fd);
+    _fd = -1;
+    _arena.release();
+    return true;
+}
+
+void RecordingWriter::fail(const char* what) {
+    perror(what);
+    if (_fd >= 0) ::close(_fd);
+    _fd = -1;     // stop recording; acquisition carries on
+}
+
+// ── BlockDecoder ───────────────────────────────────────────────────────────
+
+BlockDecoder::BlockDecoder(const uint8_t* payload, size_t len, uint64_t first_t_us)
+    : _p(payload), _end(payload + len) {
+    _state.t_us = first_t_us;
+}
+
+bool BlockDecoder::next(Record& out) {
+    if (_p >= _end) return false;
+
+    uint64_t head;
+    if (!getVarint(_p, _end, head)) return false;
+
+    int64_t dt = wrapAdd(_state.dt_us, unzigzag(head >> 1));
+    _state.t_us += static_cast<uint64_t>(dt);
+    _state.dt_us = dt;
+    out.t_us = _state.t_us;
+    out.kind = static_cast<Kind>(head & 1);
+
+    if (out.kind == Kind::Sample) {
+        uint64_t d[5];
+        for (uint64_t& v : d)
+            if (!getVarint(_p, _end, v)) return false;
+        _state.x       = wrapAdd(_state.x, unzigzag(d[0]));
+        _state.y       = wrapAdd(_state.y, unzigzag(d[1]));
+        _state.z       = wrapAdd(_state.z, unzigzag(d[2]));
+        _state.roll_q  = wrapAdd(_state.roll_q, unzigzag(d[3]));
+        _state.pitch_q = wrapAdd(_state.pitch_q, unzigzag(d[4]));
+        out.raw     = { static_cast<int16_t>(_state.x),
+                        static_cast<int16_t>(_state.y),
+                        static_cast<int16_t>(_state.z) };
+        out.roll_q  = _state.roll_q;
+        out.pitch_q = _state.pitch_q;
+    } else {
+        uint64_t type, value;
+        if (!getVarint(_p, _end, type) || !getVarint(_p, _end, value)) return false;
+        out.event = static_cast<EventType>(type);
+        out.value = unzigzag(value);
+    }
+    return true;
+}
+
+// ── RecordingReader ────────────────────────────────────────────────────────
+
+RecordingReader::RecordingReader()
+    : _fd(-1), _base(nullptr), _size(0), _had_footer(false), _file{},
+      _index(nullptr), _index_len(0) {}
+
+RecordingReader::~RecordingReader() {
+    close();
+}
+
+bool RecordingReader::open(const char* path) {
+    _fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (_fd < 0) {
+        perror("Failed to open recording");
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(_fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(FileHeader)) {
+        fprintf(stderr, "Recording %s is truncated\n", path);
+        close();
+        return false;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+
+    void* m = mmap(nullptr, size, PROT_READ, MAP_SHARED, _fd, 0);
+    if (m == MAP_FAILED) {
+        perror("Failed to map recording");
+        close();
+        return false;
+    }
+    madvise(m, size, MADV_SEQUENTIAL);
+
+    const char* error = attach(static_cast<const uint8_t*>(m), size);
+    if (error) {
+        fprintf(stderr, "Recording %s %s\n", path, error);
+        close();
+        return false;
+    }
+    if (!_had_footer) fprintf(stderr, "Recording %s has no index; scanned blocks instead\n", path);
+    return true;
+}
+
+bool RecordingReader::openBuffer(const uint8_t* data, size_t size) {
+    if (attach(data, size)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+const char* RecordingReader::attach(const uint8_t* base, size_t size) {
+    _base = base;
+    _size = size;
+    if (_size < sizeof(FileHeader)) return "is truncated";
+
+    memcpy(&_file, _base, sizeof(_file));
+    if (_file.magic != kFileMagic || _file.version != kVersion
+            || _file.block_size != kBlockSize)
+        return "has an unsupported format";
+
+    _had_footer = loadFooter();
+    if (!_had_footer && !scanBlocks()) return "could not be scanned";
+    return nullptr;
+}
+
+void RecordingReader::close() {
+    if (_base && _fd >= 0) munmap(const_cast<uint8_t*>(_base), _size);
+    if (_fd >= 0) ::close(_fd);
+    _base = nullptr;
+    _fd   = -1;
+    _size = 0;
+    _index     = nullptr;
+    _index_len = 0;
+    _scan_arena.release();
+}
+
+bool RecordingReader::loadFooter() {
+    if (_size < sizeof(FileHeader) + sizeof(Trailer)) return false;
+
+    Trailer tr;
+    memcpy(&tr, _base + _size - sizeof(tr), sizeof(tr));
+    if (tr.magic != kIndexMagic) return false;
+
+    // Every bound is checked without overflow: the footer may be garbage
+    uint64_t index_bytes = uint64_t(tr.entry_count) * sizeof(IndexEntry);
+    if (tr.index_offset > _size || tr.index_offset + index_bytes + sizeof(Trailer) != _size)
+        return false;
+    if (tr.index_offset % alignof(IndexEntry) != 0) return false;
+
+    // The footer is block-aligned plus the header, so entries can be used in place
+    const IndexEntry* entries = reinterpret_cast<const IndexEntry*>(_base + tr.index_offset);
+    for (uint32_t i = 0; i < tr.entry_count; i++) {
+        uint64_t off = entries[i].offset;
+        if (off < sizeof(FileHeader) || off > tr.index_offset || tr.index_offset - off < kBlockSize)
+            return false;
+    }
+    _index     = entries;
+    _index_len = tr.entry_count;
+    return true;
+}
+
+bool RecordingReader::scanBlocks() {
+    size_t max_blocks = (_size - sizeof(FileHeader)) / kBlockSize;
+    IndexEntry* index = nullptr;
+    if (max_blocks > 0) {
+        if (!_scan_arena.init(max_blocks * sizeof(IndexEntry))) return false;
+        index = _scan_arena.allocArray<IndexEntry>(max_blocks);
+    }
+
+    size_t n = 0;
+    for (size_t off = sizeof(FileHeader); n < max_blocks; off += kBlockSize) {
+        BlockHeader bh;
+        memcpy(&bh, _base + off, sizeof(bh));
+        if (bh.magic != kBlockMagic) break;
+        index[n++] = { off, bh.first_t_us, bh.last_t_us, bh.count, 0 };
+    }
+    _index     = index;
+    _index_len = n;
+    return true;
+}
+
+BlockDecoder RecordingReader::decoder(size_t i) const {
+    const IndexEntry& e = _index[i];
+    BlockHeader bh;
+    memcpy(&bh, _base + e.offset, sizeof(bh));
+
+    size_t len = std::min<size_t>(bh.payload_len, kBlockSize - sizeof(BlockHeader));
+    return BlockDecoder(_base + e.offset + sizeof(BlockHeader), len, bh.first_t_us);
+}
+
+size_t RecordingReader::findBlock(uint64_t t_us) const {
+    const IndexEntry* it = std::lower_bound(_index, _index + _index_len, t_us,
+        [](const IndexEntry& e, uint64_t t) { return e.last_t_us < t; });
+    return static_cast<size_t>(it - _index);
+}
+
+uint64_t RecordingReader::startUs() const {
+    return _index_len ? _index[0].first_t_us : 0;
+}
+
+uint64_t RecordingReader::endUs() const {
+    return _index_len ? _index[_index_len - 1].last_t_us : 0;
+}
+
+} // namespace rec
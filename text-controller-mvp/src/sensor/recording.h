@@ -0,0 +1,216 @@
+#ifndef RECORDING_H
+#define RECORDING_H
+
+// Compact append-only session recording.
+//
+// File layout (little-endian):
+//   FileHeader
+//   Block[0..n)           each exactly kBlockSize bytes, independently decodable
+//   IndexEntry[n]         footer, written on close()
+//   Trailer
+//
+// Inside a block every record starts with a varint head:
+//   head = zigzag(delta-of-delta of t_us) << 1 | kind
+// followed by zigzag varint deltas of the sample fields (kind 0) or an
+// event type + zigzag value (kind 1). Delta state resets at each block, so
+// a file without a footer (crash, power cut) is still readable by scanning.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "adxl343.h"
+#include "arena.h"
+
+namespace rec {
+
+constexpr uint32_t kFileMagic  = 0x43455253;    // "SREC"
+constexpr uint32_t kBlockMagic = 0x4B4C4253;    // "SBLK"
+constexpr uint32_t kIndexMagic = 0x58444953;    // "SIDX"
+constexpr uint16_t kVersion    = 1;
+constexpr uint32_t kBlockSize  = 4096;
+
+// Index capacity reserved when a recording is opened: 4 MiB of entries
+// (mapped, so only the pages in use are committed) for 512 MiB of blocks,
+// ~10 days at 100 Hz and ~6 bytes per sample. Past that no footer is
+// written and readers fall back to scanning.
+constexpr size_t kDefaultMaxBlocks = 131072;
+
+// Filtered angles are stored as fixed point, matching the %.4f wire format
+constexpr float kAngleScale = 10000.0f;
+
+struct FileHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t block_size;
+    uint32_t flags;
+    uint64_t start_realtime_us;     // wall clock at open, for humans
+    uint64_t start_monotonic_us;    // record timestamps use this clock
+};
+
+struct BlockHeader {
+    uint32_t magic;
+    uint32_t count;
+    uint64_t first_t_us;
+    uint64_t last_t_us;
+    uint32_t payload_len;
+    uint32_t reserved;
+};
+
+struct IndexEntry {
+    uint64_t offset;
+    uint64_t first_t_us;
+    uint64_t last_t_us;
+    uint32_t count;
+    uint32_t reserved;
+};
+
+struct Trailer {
+    uint64_t index_offset;
+    uint32_t entry_count;
+    uint32_t magic;
+};
+
+static_assert(sizeof(FileHeader)  == 32, "FileHeader layout");
+static_assert(sizeof(BlockHeader) == 32, "BlockHeader layout");
+static_assert(sizeof(IndexEntry)  == 32, "IndexEntry layout");
+static_assert(sizeof(Trailer)     == 16, "Trailer layout");
+
+enum class Kind : uint8_t { Sample = 0, Event = 1 };
+
+enum class EventType : uint16_t {
+    SessionStart = 1,
+    RollOffset   = 2,   // value = offset * 1e6 rad
+    PitchOffset  = 3,
+    SessionEnd   = 4,
+    Calibration  = 5,   // value = packFloats(roll offset, pitch offset), exact
+    FilterState  = 6,   // value = packFloats(filtered roll, filtered pitch)
+};
+
+// Two floats' bit patterns as one event value, so replay restores them exactly
+inline int64_t packFloats(float hi, float lo) {
+    uint32_t a, b;
+    memcpy(&a, &hi, 4);
+    memcpy(&b, &lo, 4);
+    return static_cast<int64_t>(uint64_t(a) << 32 | b);
+}
+
+inline void unpackFloats(int64_t value, float& hi, float& lo) {
+    uint32_t a = static_cast<uint32_t>(uint64_t(value) >> 32), b = static_cast<uint32_t>(value);
+    memcpy(&hi, &a, 4);
+    memcpy(&lo, &b, 4);
+}
+
+struct Record {
+    Kind      kind;
+    uint64_t  t_us;
+    RawAccel  raw;
+    int32_t   roll_q;           // filtered roll  * kAngleScale
+    int32_t   pitch_q;          // filtered pitch * kAngleScale
+    EventType event;
+    int64_t   value;
+};
+
+// Delta state shared by encoder and decoder; reset at every block boundary.
+struct DeltaState {
+    uint64_t t_us    = 0;
+    int64_t  dt_us   = 0;
+    int32_t  x = 0, y = 0, z = 0;
+    int32_t  roll_q  = 0;
+    int32_t  pitch_q = 0;
+};
+
+// ── Writer ─────────────────────────────────────────────────────────────────
+
+class RecordingWriter {
+public:
+    RecordingWriter();
+    ~RecordingWriter();
+
+    bool open(const char* path, size_t max_blocks = kDefaultMaxBlocks);
+    bool isOpen() const { return _fd >= 0; }
+
+    void writeSample(uint64_t t_us, const RawAccel& raw, float roll, float pitch);
+    void writeEvent(uint64_t t_us, EventType type, int64_t value);
+
+    // Flush the partial block and write the index footer.
+    bool close();
+
+    uint64_t bytesWritten() const { return _offset; }
+
+private:
+    int         _fd;
+    uint64_t    _offset;        // file offset of the block being filled
+    uint8_t     _block[kBlockSize];
+    size_t      _len;           // bytes used in _block (including header)
+    BlockHeader _hdr;
+    DeltaState  _state;
+    Arena       _arena;         // index storage, reserved by open()
+    IndexEntry* _index;
+    size_t      _index_len;
+    size_t      _index_cap;
+
+    void append(const Record& r);
+    bool flushBlock();
+    void fail(const char* what);
+};
+
+// ── Reader ─────────────────────────────────────────────────────────────────
+
+class BlockDecoder {
+public:
+    BlockDecoder() = default;
+    BlockDecoder(const uint8_t* payload, size_t len, uint64_t first_t_us);
+
+    bool next(Record& out);     // false at end of block or on corruption
+
+private:
+    const uint8_t* _p   = nullptr;
+    const uint8_t* _end = nullptr;
+    DeltaState     _state;
+};
+
+class RecordingReader {
+public:
+    RecordingReader();
+    ~RecordingReader();
+
+    // Map the file read-only. Uses the footer if present, otherwise scans
+    // the block headers (recording was not closed cleanly).
+    bool open(const char* path);
+    // Same, for a file already in memory (`data` must outlive the reader);
+    // fails silently
+    bool openBuffer(const uint8_t* data, size_t size);
+    void close();
+
+    size_t blockCount() const { return _index_len; }
+    const IndexEntry& block(size_t i) const { return _index[i]; }
+    BlockDecoder decoder(size_t i) const;
+
+    // Index of the first block whose samples may be at or after t_us.
+    size_t findBlock(uint64_t t_us) const;
+
+    uint64_t startUs() const;
+    uint64_t endUs() const;
+    bool     hadFooter() const { return _had_footer; }
+    const FileHeader& header() const { return _file; }
+
+private:
+    int            _fd;
+    const uint8_t* _base;
+    size_t         _size;
+    bool           _had_footer;
+    FileHeader     _file;
+    const IndexEntry* _index;   // into the mapped footer, or _scan_arena
+    size_t         _index_len;
+    Arena          _scan_arena;
+
+    const char* attach(const uint8_t* base, size_t size);    // nullptr or error
+    bool loadFooter();
+    bool scanBlocks();
+};
+
+} // namespace rec
+
+#endif // RECORDING_H
@@ -0,0 +1,23 @@
+#!/bin/sh
+# Compare sampling jitter with and without --rt while every CPU is busy.
+# Runs the simulated source, so no sensor is needed.
+#   usage: ./rt_jitter.sh [seconds] [cpu]
+set -eu
+
+DURATION=${1:-20}
+CPU=${2:-0}
+SENSOR=./sensor
+RUN="$SENSOR --simulate --rate-hz 100 --health-ms 0 --duration $DURATION"
+
+HOGS=""
+for _ in $(seq "$(nproc)"); do
+    ( while :; do :; done ) &
+    HOGS="$HOGS $!"
+done
+trap 'kill $HOGS 2>/dev/null' EXIT INT TERM
+
+echo "== SCHED_OTHER, $(nproc) CPU hogs, ${DURATION}s"
+$RUN 2>&1 >/dev/null
+echo
+echo "== --rt --cpu $CPU, $(nproc) CPU hogs, ${DURATION}s"
+$RUN --rt --cpu "$CPU" 2>&1 >/dev/null
@@ -0,0 +1,238 @@
+#include "runtime_config.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// ── Parsing ────────────────────────────────────────────────────────────────
+
+namespace {
+
+enum class Type { String, Int, Float };
+
+struct Key {
+    const char* name;
+    Type        type;
+    size_t      offset;
+    double      min, max;
+    bool        restart;        // only takes effect on the next start
+};
+
+#define KEY(field, type, lo, hi, restart) \
+    { #field, Type::type, offsetof(SensorConfig, field), lo, hi, restart }
+
+const Key kKeys[] = {
+    KEY(i2c_device,        String, 0,    0,     true),
+    KEY(i2c_addr,          Int,    0x03, 0x77,  true),     // 7-bit, non-reserved
+    KEY(filter_alpha,      Float,  1e-6, 1.0,   false),
+};
+
+#undef KEY
+
+const Key* findKey(const char* name, size_t len) {
+    for (const Key& k : kKeys)
+        if (strlen(k.name) == len && memcmp(k.name, name, len) == 0) return &k;
+    return nullptr;
+}
+
+const char* trim(const char*& p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    while (end > p && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) end--;
+    return end;
+}
+
+// Store one value; returns a static reason string on failure.
+const char* setValue(const Key& k, const char* v, size_t len, SensorConfig& out) {
+    char buf[64];
+    if (len == 0) return "empty value";
+    if (len >= sizeof(buf)) return "value too long";
+    memcpy(buf, v, len);
+    buf[len] = '\0';
+
+    char* field = reinterpret_cast<char*>(&out) + k.offset;
+    if (k.type == Type::String) {
+        memcpy(field, buf, len + 1);
+        return nullptr;
+    }
+
+    char* end;
+    errno = 0;
+    double d = (k.type == Type::Float) ? strtod(buf, &end)
+                                       : static_cast<double>(strtol(buf, &end, 0));
+    if (errno != 0 || end == buf || *end != '\0') return "not a number";
+    if (!(d >= k.min && d <= k.max)) return "out of range";
+
+    switch (k.type) {
+    case Type::Int:   *reinterpret_cast<int*>(field)      = static_cast<int>(d);      break;
+    case Type::Float: *reinterpret_cast<float*>(field)    = static_cast<float>(d);    break;
+    case Type::String: break;
+    }
+    return nullptr;
+}
+
+} // namespace
+
+bool parseConfig(const char* text, size_t len, SensorConfig& out, char* err, size_t err_cap) {
+    const char* p   = text;
+    const char* end = text + len;
+    for (int line_no = 1; p < end; line_no++) {
+        const char* eol = static_cast<const char*>(memchr(p, '\n', static_cast<size_t>(end - p)));
+        if (!eol) eol = end;
+        const char* line = p;
+        p = (eol < end) ? eol + 1 : end;
+
+        const char* hash = static_cast<const char*>(memchr(line, '#', static_cast<size_t>(eol - line)));
+        const char* stop = trim(line, hash ? hash : eol);
+        if (line == stop) continue;
+
+        const char* eq = static_cast<const char*>(memchr(line, '=', static_cast<size_t>(stop - line)));
+        if (!eq) {
+            snprintf(err, err_cap, "line %d: expected key = value", line_no);
+            return false;
+        }
+        const char* key = line;
+        const char* key_end = trim(key, eq);
+        const char* val = eq + 1;
+        const char* val_end = trim(val, stop);
+
+        const Key* k = findKey(key, static_cast<size_t>(key_end - key));
+        if (!k) {
+            snprintf(err, err_cap, "line %d: unknown key '%.*s'", line_no,
+                     static_cast<int>(key_end - key), key);
+            return false;
+        }
+        if (const char* why = setValue(*k, val, static_cast<size_t>(val_end - val), out)) {
+            snprintf(err, err_cap, "line %d: %s: %s", line_no, k->name, why);
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t formatConfig(char* buf, size_t cap, const SensorConfig& c, const char* source) {
+    int n = snprintf(buf, cap, "#CONFIG source=%s filter_alpha=%g\n", source, c.filter_alpha);
+    if (n < 0) return 0;
+    return static_cast<size_t>(n) < cap ? static_cast<size_t>(n) : cap - 1;
+}
+
+// ── ConfigStore ────────────────────────────────────────────────────────────
+
+#ifndef SENSOR_STATIC_CONFIG
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+static constexpr size_t kMaxConfigSize = 16 * 1024;
+
+ConfigStore::ConfigStore()
+    : _path(), _name(_path), _loaded(false), _inotify_fd(-1), _current(kDefaultConfig) {}
+
+ConfigStore::~ConfigStore() {
+    if (_inotify_fd >= 0) close(_inotify_fd);
+}
+
+bool ConfigStore::readFile(SensorConfig& out, char* err, size_t err_cap, bool& missing) const {
+    missing = false;
+    int fd = open(_path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        missing = (errno == ENOENT);
+        snprintf(err, err_cap, "%s", strerror(errno));
+        return false;
+    }
+    static char text[kMaxConfigSize + 1];
+    ssize_t n = read(fd, text, sizeof(text));
+    close(fd);
+    if (n < 0) {
+        snprintf(err, err_cap, "%s", strerror(errno));
+        return false;
+    }
+    if (static_cast<size_t>(n) > kMaxConfigSize) {
+        snprintf(err, err_cap, "file larger than %zu bytes", kMaxConfigSize);
+        return false;
+    }
+    out = kDefaultConfig;       // keys absent from the file revert to defaults
+    return parseConfig(text, static_cast<size_t>(n), out, err, err_cap);
+}
+
+bool ConfigStore::load(const char* path, bool required) {
+    if (snprintf(_path, sizeof(_path), "%s", path) >= static_cast<int>(sizeof(_path))) {
+        fprintf(stderr, "Config path too long: %s\n", path);
+        return false;
+    }
+    const char* slash = strrchr(_path, '/');
+    _name = slash ? slash + 1 : _path;
+
+    char err[128];
+    bool missing;
+    SensorConfig next;
+    if (!readFile(next, err, sizeof(err), missing)) {
+        if (missing && !required) return true;      // defaults, still watched
+        fprintf(stderr, "Config %s: %s\n", _path, err);
+        return false;
+    }
+    _current = next;
+    _loaded  = true;
+    return true;
+}
+
+bool ConfigStore::reload(char* err, size_t err_cap) {
+    bool missing;
+    SensorConfig next;
+    if (!readFile(next, err, err_cap, missing)) return false;
+
+    for (const Key& k : kKeys) {
+        if (!k.restart) continue;
+        const char* now  = reinterpret_cast<const char*>(&_current) + k.offset;
+        char*       want = reinterpret_cast<char*>(&next) + k.offset;
+        size_t size = (k.type == Type::String) ? sizeof(SensorConfig::i2c_device) : sizeof(int);
+        bool differs = (k.type == Type::String) ? strcmp(now, want) != 0
+                                                : memcmp(now, want, size) != 0;
+        if (differs)
+            fprintf(stderr, "Config: %s change takes effect on restart\n", k.name);
+        memcpy(want, now, size);
+    }
+    _current = next;
+    _loaded  = true;
+    return true;
+}
+
+bool ConfigStore::watch() {
+    _inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (_inotify_fd < 0) {
+        perror("inotify_init1");
+        return false;
+    }
+    char dir[sizeof(_path)];
+    size_t dir_len = static_cast<size_t>(_name - _path);
+    if (dir_len == 0) {
+        strcpy(dir, ".");
+    } else {
+        memcpy(dir, _path, dir_len);
+        dir[dir_len] = '\0';
+    }
+    if (inotify_add_watch(_inotify_fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        // Directory doesn't exist: RELOAD still works, inotify doesn't
+        close(_inotify_fd);
+        _inotify_fd = -1;
+        return false;
+    }
+    return true;
+}
+
+bool ConfigStore::consumeWatch() {
+    alignas(inotify_event) char buf[4096];
+    bool changed = false;
+    ssize_t n;
+    while ((n = read(_inotify_fd, buf, sizeof(buf))) > 0) {
+        for (char* p = buf; p < buf + n; ) {
+            const inotify_event* ev = reinterpret_cast<const inotify_event*>(p);
+            if (ev->len > 0 && strcmp(ev->name, _name) == 0) changed = true;
+            p += sizeof(inotify_event) + ev->len;
+        }
+    }
+    return changed;
+}
+
+#endif // SENSOR_STATIC_CONFIG
@@ -0,0 +1,98 @@
+#ifndef RUNTIME_CONFIG_H
+#define RUNTIME_CONFIG_H
+
+// Runtime tunables, overriding the defaults in config.h.
+//
+// The file is plain `key = value` lines; `#` starts a comment. Every key
+// is typed and range-checked, unknown keys are errors (so a typo cannot
+// silently fall back to a default), and a file with any error is rejected
+// as a whole:
+//
+//   i2c_device        = /dev/i2c-1     restart
+//   i2c_addr          = 0x53           restart
+//   filter_alpha      = 0.2            live, (0, 1]
+//
+// Reloads happen on the reactor thread between samples, so a sample is
+// always processed under one complete configuration. "restart" keys keep
+// their running value until the next start.
+//
+// Gesture tuning (deadzone, dwell, cooldowns) belongs to the app, not the
+// sensor: see input_processor.py and app_state.py.
+//
+// Built with SENSOR_STATIC_CONFIG, ConfigStore is a constexpr view of the
+// config.h macros and files are never read.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include "config.h"
+
+struct SensorConfig {
+    char     i2c_device[64];
+    int      i2c_addr;
+    float    filter_alpha;
+};
+
+constexpr SensorConfig kDefaultConfig = { I2C_DEVICE, ADXL343_ADDR, FILTER_ALPHA };
+
+// Parse a whole config file on top of `out` (normally kDefaultConfig).
+// On failure writes "line N: reason" to err and leaves `out` unspecified.
+bool parseConfig(const char* text, size_t len, SensorConfig& out, char* err, size_t err_cap);
+
+// "#CONFIG key=value ..." line for consumers that share these tunables
+size_t formatConfig(char* buf, size_t cap, const SensorConfig& c, const char* source);
+
+#ifdef SENSOR_STATIC_CONFIG
+
+class ConfigStore {
+public:
+    bool load(const char*, bool) { return true; }
+    bool reload(char* err, size_t err_cap) {
+        snprintf(err, err_cap, "static build");
+        return false;
+    }
+    bool watch()                 { return false; }
+    int  watchFd() const         { return -1; }
+    bool consumeWatch()          { return false; }
+    const char* source() const   { return "static"; }
+
+    static constexpr const SensorConfig& current() { return kDefaultConfig; }
+};
+
+#else
+
+class ConfigStore {
+public:
+    ConfigStore();
+    ~ConfigStore();
+
+    // Load `path`. A missing file is only an error when `required`.
+    bool load(const char* path, bool required);
+
+    // Re-read the file; on success the new values replace current()
+    // except for restart-only keys. On failure current() is untouched.
+    bool reload(char* err, size_t err_cap);
+
+    // inotify on the file's directory, so editors that write a temp file
+    // and rename it over the original are seen too.
+    bool watch();
+    int  watchFd() const { return _inotify_fd; }
+    bool consumeWatch();        // drain events; true if the file changed
+
+    const char* source() const { return _loaded ? "file" : "defaults"; }
+    const SensorConfig& current() const { return _current; }
+
+private:
+    char         _path[256];
+    const char*  _name;         // basename within _path
+    bool         _loaded;
+    int          _inotify_fd;
+    SensorConfig _current;
+
+    bool readFile(SensorConfig& out, char* err, size_t err_cap, bool& missing) const;
+};
+
+#endif // SENSOR_STATIC_CONFIG
+
+#endif // RUNTIME_CONFIG_H
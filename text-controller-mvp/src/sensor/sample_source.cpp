@@ -0,0 +1,58 @@
+#include "sample_source.h"
+#include "clock.h"
+
+#include <cmath>
+
+ReadStatus LiveSource::read(RawSample& out) {
+    out.t_us = monotonicUs();
+    return _sensor.readRaw(out.accel) ? ReadStatus::Ok : ReadStatus::Error;
+}
+
+SimulatedSource::SimulatedSource(uint32_t seed)
+    : _rng(seed ? seed : 1), _t0_us(0) {}
+
+ReadStatus SimulatedSource::read(RawSample& out) {
+    out.t_us = monotonicUs();
+    if (_t0_us == 0) _t0_us = out.t_us;
+    float t = (out.t_us - _t0_us) / 1e6f;
+
+    // Nods and tilts of up to ~0.4 rad every few seconds
+    float roll  = 0.4f * sinf(t * 0.9f);
+    float pitch = 0.3f * sinf(t * 0.55f + 1.0f);
+
+    auto noise = [this]() {     // xorshift32, +-2 LSB
+        _rng ^= _rng << 13;
+        _rng ^= _rng >> 17;
+        _rng ^= _rng << 5;
+        return static_cast<int>(_rng % 5) - 2;
+    };
+    out.accel.x = static_cast<int16_t>(-256.0f * sinf(pitch) + noise());
+    out.accel.y = static_cast<int16_t>(256.0f * sinf(roll) * cosf(pitch) + noise());
+    out.accel.z = static_cast<int16_t>(256.0f * cosf(roll) * cosf(pitch) + noise());
+    return ReadStatus::Ok;
+}
+
+ReplaySource::ReplaySource(const rec::RecordingReader& reader)
+    : _reader(reader), _start_us(0), _block(0) {}
+
+void ReplaySource::seek(uint64_t start_us) {
+    _start_us = start_us;
+    _block    = _reader.findBlock(start_us);
+    _dec      = _block < _reader.blockCount() ? _reader.decoder(_block) : rec::BlockDecoder();
+}
+
+ReadStatus ReplaySource::read(RawSample& out) {
+    rec::Record r;
+    while (_block < _reader.blockCount()) {
+        if (!_dec.next(r)) {
+            if (++_block < _reader.blockCount()) _dec = _reader.decoder(_block);
+            continue;
+        }
+        if (r.kind != rec::Kind::Sample || r.t_us < _start_us) continue;
+
+        out.t_us  = r.t_us;
+        out.accel = r.raw;
+        return ReadStatus::Ok;
+    }
+    return ReadStatus::End;
+}
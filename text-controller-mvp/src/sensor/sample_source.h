@@ -0,0 +1,62 @@
+#ifndef SAMPLE_SOURCE_H
+#define SAMPLE_SOURCE_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "adxl343.h"
+#include "recording.h"
+
+struct RawSample {
+    uint64_t t_us;          // CLOCK_MONOTONIC (live) or recorded time (replay)
+    RawAccel accel;
+};
+
+enum class ReadStatus { Ok, Error, End };
+
+// Where the pipeline gets its samples from. Live hardware and recorded
+// sessions go through the same interface so replay exercises the same code.
+class SampleSource {
+public:
+    virtual ~SampleSource() = default;
+    virtual ReadStatus read(RawSample& out) = 0;
+};
+
+class LiveSource : public SampleSource {
+public:
+    explicit LiveSource(Adxl343& sensor) : _sensor(sensor) {}
+    ReadStatus read(RawSample& out) override;
+
+private:
+    Adxl343& _sensor;
+};
+
+// Synthetic head movement (slow tilts plus sensor noise) stamped with the
+// live clock, for running and measuring without hardware.
+class SimulatedSource : public SampleSource {
+public:
+    explicit SimulatedSource(uint32_t seed = 1);
+    ReadStatus read(RawSample& out) override;
+
+private:
+    uint32_t _rng;
+    uint64_t _t0_us;
+};
+
+class ReplaySource : public SampleSource {
+public:
+    explicit ReplaySource(const rec::RecordingReader& reader);
+
+    // Position at the first sample at or after start_us; call after the
+    // reader has been opened.
+    void seek(uint64_t start_us);
+    ReadStatus read(RawSample& out) override;
+
+private:
+    const rec::RecordingReader& _reader;
+    uint64_t          _start_us;
+    size_t            _block;
+    rec::BlockDecoder _dec;
+};
+
+#endif // SAMPLE_SOURCE_H
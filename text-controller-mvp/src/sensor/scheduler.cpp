@@ -0,0 +1,49 @@
+#include "scheduler.h"
+
+#include <cstring>
+
+bool parseCatchUp(const char* name, CatchUp& out) {
+    if (strcmp(name, "skip")  == 0) { out = CatchUp::Skip;  return true; }
+    if (strcmp(name, "burst") == 0) { out = CatchUp::Burst; return true; }
+    if (strcmp(name, "shift") == 0) { out = CatchUp::Shift; return true; }
+    return false;
+}
+
+PeriodicTimer::PeriodicTimer(uint64_t period_ns, CatchUp policy)
+    : _period_ns(period_ns), _policy(policy), _deadline_ns(0),
+      _ticks(0), _late(0), _skipped(0), _last_late_ns(0) {}
+
+void PeriodicTimer::start(uint64_t now_ns) {
+    _deadline_ns = now_ns + _period_ns;
+    _ticks = _late = _skipped = 0;
+    _jitter.reset();
+}
+
+unsigned PeriodicTimer::complete(uint64_t now_ns) {
+    uint64_t lateness = now_ns > _deadline_ns ? now_ns - _deadline_ns : 0;
+    uint64_t behind   = lateness / _period_ns;    // whole periods overrun
+    _jitter.record(lateness);
+    _last_late_ns = lateness;
+    _ticks++;
+    if (behind > 0) _late++;
+
+    unsigned dropped = 0;
+    CatchUp policy = _policy;
+    if (policy == CatchUp::Burst && behind > kMaxBurst) policy = CatchUp::Skip;
+
+    switch (policy) {
+    case CatchUp::Skip:
+        _deadline_ns += (behind + 1) * _period_ns;
+        dropped = static_cast<unsigned>(behind);
+        break;
+    case CatchUp::Burst:
+        _deadline_ns += _period_ns;
+        break;
+    case CatchUp::Shift:
+        _deadline_ns = now_ns + _period_ns;
+        dropped = static_cast<unsigned>(behind);
+        break;
+    }
+    _skipped += dropped;
+    return dropped;
+}
@@ -0,0 +1,52 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <cstdint>
+
+#include "histogram.h"
+
+// What to do when one or more deadlines have already passed on wake-up.
+enum class CatchUp {
+    Skip,       // stay on the original grid, drop the missed ticks
+    Burst,      // run the missed ticks back-to-back, then resume the grid
+    Shift,      // re-anchor the grid at the late wake-up
+};
+
+bool parseCatchUp(const char* name, CatchUp& out);
+
+// Fixed-rate ticks on absolute CLOCK_MONOTONIC deadlines. Work time and
+// scheduler delay do not accumulate into the period the way a relative
+// sleep after the work does.
+class PeriodicTimer {
+public:
+    PeriodicTimer(uint64_t period_ns, CatchUp policy);
+
+    void start(uint64_t now_ns);
+
+    // Account for a wake-up at now_ns and advance the deadline; returns
+    // the ticks that were not run. The caller sleeps (a timerfd armed at
+    // nextDeadline()) and calls this on each expiration.
+    unsigned complete(uint64_t now_ns);
+
+    uint64_t period()       const { return _period_ns; }
+    uint64_t nextDeadline() const { return _deadline_ns; }
+    uint64_t ticks()        const { return _ticks; }
+    uint64_t late()         const { return _late; }     // woke past a whole period
+    uint64_t skipped()      const { return _skipped; }
+    uint64_t lastLateness() const { return _last_late_ns; }
+    const Histogram& jitter() const { return _jitter; } // wake - deadline, ns
+
+private:
+    static constexpr unsigned kMaxBurst = 4;
+
+    uint64_t  _period_ns;
+    CatchUp   _policy;
+    uint64_t  _deadline_ns;
+    uint64_t  _ticks;
+    uint64_t  _late;
+    uint64_t  _skipped;
+    uint64_t  _last_late_ns;
+    Histogram _jitter;
+};
+
+#endif // SCHEDULER_H
@@ -0,0 +1,715 @@
+#include "sensor_app.h"
+#include "alloc_guard.h"
+#include "clock.h"
+#include "cpu_usage.h"
+#include "state_file.h"
+
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/time.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+
+static constexpr int kStdoutReply = -1;
+
+SensorApp::SensorApp(const AppOptions& opt, ConfigStore& config)
+    : _opt(opt),
+      _config(config),
+      _sensor(config.current().i2c_device, config.current().i2c_addr),
+      _live(_sensor),
+      _replay_source(_replay),
+      _source(nullptr),
+      _source_name("live"),
+      _replaying(false),
+      _pipeline(config.current().filter_alpha),
+      _health(opt.health_ms * 1000ull),
+      _timer(static_cast<uint64_t>(1e9 / opt.rate_hz), opt.catch_up),
+      _out(STDOUT_FILENO),
+      _timer_fd(-1),
+      _signal_fd(-1),
+      _phase(Phase::Calibrating),
+      _cal_count(0),
+      _session_t0_us(0),
+      _end_us(UINT64_MAX),
+      _last_t_us(0),
+      _cpu_next_us(0),
+      _stop_ns(0),
+      _start_time_s(0),
+      _stop_reason("end"),
+      _frame(),
+      _pending(),
+      _have_pending(false),
+      _replay_first_t_us(0),
+      _replay_wall_t0_ns(0),
+      _replay_calibrated(false),
+      _replay_warm(false),
+      _replay_cal_t_us(0) {}
+
+SensorApp::~SensorApp() {
+    if (_timer_fd >= 0)  close(_timer_fd);
+    if (_signal_fd >= 0) close(_signal_fd);
+}
+
+int SensorApp::run() {
+    if (!setup()) return 1;
+    _reactor.run();
+    finish();
+    return 0;
+}
+
+// ── Setup / teardown ───────────────────────────────────────────────────────
+
+bool SensorApp::setup() {
+    // Signals arrive through the reactor; block them before any thread
+    // starts so the output thread inherits the mask.
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    sigaddset(&mask, SIGUSR1);      // dump stage timings and the event trace
+    pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+
+    _session_t0_us = monotonicUs();
+    if (_opt.replay_path) {
+        if (!_replay.open(_opt.replay_path)) return false;
+        uint64_t from = _replay.startUs() + static_cast<uint64_t>(_opt.replay_from_s * 1e6);
+        _replay_calibrated = restoreRecordedCalibration(from);
+        _replay_source.seek(from);
+        _source        = &_replay_source;
+        _source_name   = "replay";
+        _replaying     = true;
+        _session_t0_us = from;
+        fprintf(stderr, "Replaying %s (%zu blocks, %.1f s)\n", _opt.replay_path,
+                _replay.blockCount(), (_replay.endUs() - _replay.startUs()) / 1e6);
+    } else if (_opt.simulate) {
+        _source      = &_simulated;
+        _source_name = "simulate";
+    } else {
+        if (!_sensor.init()) return false;
+        _source = &_live;
+    }
+
+    enterRealtime(_opt.rt);
+    trace::attachThread("loop");
+    cpu::attachThread("loop");
+    _out.setLossless(_replaying);
+    if (!_out.start(_opt.rt) || !_reactor.init()) return false;
+    // Supervise every sensor read, calibration and a warm start's first included
+    if (!_replaying) _watchdog.start(_opt.stall_ms, _opt.rt, _out);
+
+    _signal_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    _timer_fd  = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (_signal_fd < 0 || _timer_fd < 0) {
+        perror("Failed to create signalfd/timerfd");
+        return false;
+    }
+    if (!_reactor.add(_signal_fd, EPOLLIN, onSignal, this)
+            || !_reactor.add(_timer_fd, EPOLLIN, onTimer, this))
+        return false;
+
+    // Control channel is optional: /dev/null or a regular file cannot be polled
+    if (!_reactor.add(STDIN_FILENO, EPOLLIN, onControl, this))
+        fprintf(stderr, "Control channel on stdin unavailable\n");
+
+    if (_config.watch() && !_reactor.add(_config.watchFd(), EPOLLIN, onConfigWatch, this))
+        return false;
+
+    if (_opt.socket_path && !_subs.listen(_opt.socket_path, _reactor, onSubscriberLine, this))
+        return false;
+
+    _start_time_s = realtimeUs() / 1e6;
+    if (!_metrics.start(_opt.metrics_path, _opt.metrics_socket, _opt.metrics_ms, _opt.rt,
+                        formatMetrics, this))
+        return false;
+
+    // Handshake first, so consumers can configure before the first frame
+    sendHello(kStdoutReply);
+    sendConfig(kStdoutReply);
+    _out.flush();
+
+    if (_opt.record_path && _recorder.open(_opt.record_path))
+        _recorder.writeEvent(_session_t0_us, rec::EventType::SessionStart, _replaying);
+
+    uint64_t now = monotonicNs();
+    PersistedState saved;
+    if (_opt.warm_start && !_replaying && _opt.state_path
+            && loadState(_opt.state_path, WARM_START_MAX_AGE, saved)) {
+        // Warm restart: reuse the last calibration and filter state
+        _pipeline.restoreState(saved.pipeline);
+        finishCalibration(monotonicUs());
+        startStreaming(now, true);
+    } else if (_replaying) {
+        if (_replay_calibrated) {
+            finishCalibration(_replay_cal_t_us);
+            startStreaming(now, _replay_warm);
+        }
+        _have_pending = _source->read(_pending) == ReadStatus::Ok;
+        if (!_have_pending) {
+            fprintf(stderr, "Recording has no samples\n");
+            return false;
+        }
+        arm(replayDueNs(_pending.t_us));
+    } else {
+        arm(now);       // first calibration sample straight away
+    }
+    return true;
+}
+
+void SensorApp::requestStop(const char* reason) {
+    if (_stop_ns == 0) {
+        _stop_ns     = monotonicNs();
+        _stop_reason = reason;
+    }
+    _reactor.stop();
+}
+
+// Runs once the reactor has stopped: the tick in progress has completed, so
+// there is no half-built frame. Everything below is bounded by shutdown_ms.
+void SensorApp::finish() {
+    if (_stop_ns == 0) _stop_ns = monotonicNs();
+    alloc::disarm();        // shutdown may use stdio and the heap
+    _watchdog.stop();
+
+    // Hard cap: SIGALRM's default action ends the process if anything hangs
+    itimerval budget = {};
+    budget.it_value.tv_sec  = _opt.shutdown_ms / 1000;
+    budget.it_value.tv_usec = (_opt.shutdown_ms % 1000) * 1000;
+    setitimer(ITIMER_REAL, &budget, nullptr);
+
+    if (!_replaying && _phase == Phase::Streaming) {
+        fprintf(stderr, "Deadlines: %llu ticks, %llu late, %llu skipped\n",
+                static_cast<unsigned long long>(_timer.ticks()),
+                static_cast<unsigned long long>(_timer.late()),
+                static_cast<unsigned long long>(_timer.skipped()));
+        _timer.jitter().print(stderr, "Period jitter (wake - deadline)", 1e3, "us");
+        _stages.print(stderr);
+        _watchdog.print(stderr);
+    }
+    if (_opt.cpu_ms) cpu::print(stderr);
+    if (alloc::kEnabled) {
+        alloc::Stats a = alloc::stats();
+        fprintf(stderr, "Allocations: %llu (%llu bytes), %llu after warm-up\n",
+                static_cast<unsigned long long>(a.count),
+                static_cast<unsigned long long>(a.bytes),
+                static_cast<unsigned long long>(a.after_arm));
+    }
+
+    if (_phase == Phase::Streaming && !_replaying && _opt.state_path) {
+        PersistedState st = { _pipeline.saveState(), realtimeUs() };
+        saveState(_opt.state_path, st);
+    }
+    if (_source == &_live && !_sensor.standby())
+        fprintf(stderr, "ADXL343 standby failed\n");
+
+    if (_recorder.isOpen()) {
+        _recorder.writeEvent(_replaying ? _last_t_us : monotonicUs(),
+                             rec::EventType::SessionEnd, 0);
+        _recorder.close();
+    }
+
+    double ms = (monotonicNs() - _stop_ns) / 1e6;
+    int n = snprintf(_line, sizeof(_line), "#BYE reason=%s shutdown_ms=%.1f\n", _stop_reason, ms);
+    emit(_line, static_cast<size_t>(n));
+    _out.stop();
+    _subs.close();
+    _metrics.stop();
+
+    fprintf(stderr, "Shutdown (%s) in %.1f ms\n", _stop_reason, (monotonicNs() - _stop_ns) / 1e6);
+    budget = {};
+    setitimer(ITIMER_REAL, &budget, nullptr);
+}
+
+void SensorApp::arm(uint64_t deadline_ns) {
+    itimerspec its = {};
+    if (deadline_ns == 0) deadline_ns = 1;      // zero would disarm
+    its.it_value.tv_sec  = static_cast<time_t>(deadline_ns / 1'000'000'000ull);
+    its.it_value.tv_nsec = static_cast<long>(deadline_ns % 1'000'000'000ull);
+    timerfd_settime(_timer_fd, TFD_TIMER_ABSTIME, &its, nullptr);
+}
+
+// Replay pacing: recorded timestamps, scaled, relative to the first sample.
+uint64_t SensorApp::replayDueNs(uint64_t t_us) {
+    if (_replay_wall_t0_ns == 0) {
+        _replay_first_t_us = t_us;
+        _replay_wall_t0_ns = monotonicNs();
+    }
+    if (_opt.replay_speed <= 0.0) return 1;     // already due
+    return _replay_wall_t0_ns
+         + static_cast<uint64_t>((t_us - _replay_first_t_us) * 1e3 / _opt.replay_speed);
+}
+
+// ── Sampling state machine ─────────────────────────────────────────────────
+
+void SensorApp::onTimer(void* self, int fd, uint32_t) {
+    uint64_t expirations;
+    if (read(fd, &expirations, sizeof(expirations)) < 0) return;
+    static_cast<SensorApp*>(self)->tick();
+}
+
+void SensorApp::tick() {
+    uint64_t now = monotonicNs();
+    if (_replaying) {
+        replayTick(now);
+        return;
+    }
+
+    RawSample s;
+    switch (_phase) {
+    case Phase::Calibrating:
+        heartbeat(now);
+        if (_source->read(s) == ReadStatus::Ok) calibrateStep(s);
+        if (_cal_count < kCalibrationSamples) {
+            arm(now + kCalibrationPeriodNs);
+        } else {
+            finishCalibration(monotonicUs());
+            _phase = Phase::Settling;
+            arm(now + kSettleNs);
+            _watchdog.beat(now + kSettleNs);    // nothing runs until then
+        }
+        break;
+
+    case Phase::Settling:
+        startStreaming(now, false);
+        break;
+
+    case Phase::Streaming: {
+        if (uint64_t missed = _timer.complete(now)) _counters.dropped.inc(missed);
+        _health.recordJitter(_timer.lastLateness());
+        heartbeat(now);
+
+        uint64_t work_start = monotonicNs();
+        _stages.begin();
+        ReadStatus st = _source->read(s);
+        _stages.lap(proto::Read);
+        streamStep(s, st, work_start);
+        arm(_timer.nextDeadline());
+        break;
+    }
+    }
+}
+
+// Before each sensor read: a read the watchdog interrupted left the bus
+// in an unknown state, so reopen it
+void SensorApp::heartbeat(uint64_t now_ns) {
+    _watchdog.beat(now_ns);
+    if (_watchdog.takeReset() && _source == &_live) {
+        fprintf(stderr, "Watchdog: reopening %s\n", _config.current().i2c_device);
+        _sensor.reset();
+    }
+}
+
+void SensorApp::replayTick(uint64_t now_ns) {
+    int budget = _opt.replay_speed > 0.0 ? 1 : kReplayBatch;
+    while (budget-- > 0 && _have_pending && _reactor.running()) {
+        if (replayDueNs(_pending.t_us) > now_ns) break;
+
+        uint64_t  work_start = monotonicNs();
+        _stages.begin();
+        RawSample s = _pending;
+        _have_pending = _source->read(_pending) == ReadStatus::Ok;
+        _stages.lap(proto::Read);
+
+        if (_phase == Phase::Calibrating) {
+            calibrateStep(s);
+            if (_cal_count == kCalibrationSamples) {
+                finishCalibration(s.t_us);
+                startStreaming(now_ns, false);
+            }
+        } else {
+            streamStep(s, ReadStatus::Ok, work_start);
+        }
+    }
+
+    if (!_have_pending) {
+        requestStop("end");
+        return;
+    }
+    arm(replayDueNs(_pending.t_us));
+}
+
+// The calibration the recording was made with, so replay applies it rather
+// than deriving its own: the offsets and filter state written when
+// calibration finished (recordings older than the exact events have the
+// rounded offsets only), and, when replay starts later on, the filtered
+// angles recorded just before that point. Moves from_us past the
+// calibration samples. False if the recording has no offsets.
+bool SensorApp::restoreRecordedCalibration(uint64_t& from_us) {
+    Pipeline::State st{};
+    bool have_roll = false, have_pitch = false, exact = false, streaming = false, done = false;
+    _replay_warm = true;
+    for (size_t b = 0; b < _replay.blockCount() && !done; b++) {
+        rec::BlockDecoder dec = _replay.decoder(b);
+        rec::Record       r;
+        while (!done && dec.next(r)) {
+            if (r.kind == rec::Kind::Sample) {
+                if (!have_roll || !have_pitch) {
+                    _replay_warm = false;       // a calibration sample
+                } else if (r.t_us >= from_us) {
+                    done = true;
+                } else {
+                    streaming        = true;
+                    st.filtered_roll  = r.roll_q  / rec::kAngleScale;
+                    st.filtered_pitch = r.pitch_q / rec::kAngleScale;
+                }
+                continue;
+            }
+            if (streaming) continue;
+            switch (r.event) {
+            case rec::EventType::RollOffset:
+                if (!exact) st.roll_offset = static_cast<float>(r.value / 1e6);
+                have_roll        = true;
+                _replay_cal_t_us = r.t_us;
+                break;
+            case rec::EventType::PitchOffset:
+                if (!exact) st.pitch_offset = static_cast<float>(r.value / 1e6);
+                have_pitch = true;
+                break;
+            case rec::EventType::Calibration:
+                rec::unpackFloats(r.value, st.roll_offset, st.pitch_offset);
+                exact = true;
+                break;
+            case rec::EventType::FilterState:
+                rec::unpackFloats(r.value, st.filtered_roll, st.filtered_pitch);
+                break;
+            default:
+                break;
+            }
+        }
+    }
+    if (!have_roll || !have_pitch) return false;
+
+    _pipeline.restoreState(st);
+    if (from_us <= _replay_cal_t_us) from_us = _replay_cal_t_us + 1;
+    fprintf(stderr, "Replay: using the recorded calibration (%s)\n", _replay_warm ? "warm" : "fresh");
+    return true;
+}
+
+void SensorApp::calibrateStep(const RawSample& s) {
+    _pipeline.addCalibrationSample(s.accel);
+    // Calibration input is recorded too so replay derives the same offsets
+    if (_recorder.isOpen()) _recorder.writeSample(s.t_us, s.accel, 0.0f, 0.0f);
+    _last_t_us = s.t_us;
+    _cal_count++;
+}
+
+void SensorApp::finishCalibration(uint64_t t_us) {
+    if (_cal_count > 0) _pipeline.finishCalibration();
+    _gauges.calibration_warm.set(_cal_count == 0);
+    _gauges.roll_offset.set(_pipeline.rollOffset());
+    _gauges.pitch_offset.set(_pipeline.pitchOffset());
+    _gauges.roll_spread.set(_pipeline.rollSpread());
+    _gauges.pitch_spread.set(_pipeline.pitchSpread());
+    if (_recorder.isOpen()) {
+        _recorder.writeEvent(t_us, rec::EventType::RollOffset,
+                             lrint(_pipeline.rollOffset() * 1e6));
+        _recorder.writeEvent(t_us, rec::EventType::PitchOffset,
+                             lrint(_pipeline.pitchOffset() * 1e6));
+        Pipeline::State st = _pipeline.saveState();
+        _recorder.writeEvent(t_us, rec::EventType::Calibration,
+                             rec::packFloats(st.roll_offset, st.pitch_offset));
+        _recorder.writeEvent(t_us, rec::EventType::FilterState,
+                             rec::packFloats(st.filtered_roll, st.filtered_pitch));
+    }
+}
+
+void SensorApp::startStreaming(uint64_t now_ns, bool warm) {
+    _phase = Phase::Streaming;
+    int n = snprintf(_line, sizeof(_line), "#READY calibration=%s\n", warm ? "warm" : "fresh");
+    emit(_line, static_cast<size_t>(n));
+    _timer.start(now_ns);
+    _health.start(now_ns / 1000);
+    _cpu_next_us = now_ns / 1000 + _opt.cpu_ms * 1000ull;
+    _stages.reset();
+    if (_opt.duration_s > 0)
+        _end_us = now_ns / 1000 + static_cast<uint64_t>(_opt.duration_s * 1e6);
+    if (!_replaying) arm(_timer.nextDeadline());
+}
+
+void SensorApp::streamStep(const RawSample& s, ReadStatus st, uint64_t work_start_ns) {
+    _counters.i2c_errors.set(_sensor.errorCount());
+    _counters.stalls.set(_watchdog.stalls());
+    if (st != ReadStatus::Ok) {
+        _counters.dropped.inc();
+    } else {
+        Orientation a = _pipeline.angles(s.accel);
+        _stages.lap(proto::Math);
+        Orientation o = _pipeline.filter(a);
+        _stages.lap(proto::Filter);
+        if (_recorder.isOpen()) _recorder.writeSample(s.t_us, s.accel, o.roll, o.pitch);
+        _last_t_us = s.t_us;
+
+        _frame.seq++;
+        if (_frame.seq == kAllocWarmupFrames) alloc::arm(true);
+        _frame.t_us  = s.t_us;
+        _frame.raw   = s.accel;
+        _frame.roll  = o.roll;
+        _frame.pitch = o.pitch;
+        if (_opt.fields & proto::bit(proto::TxUs)) _frame.tx_us = monotonicUs();
+        size_t n = proto::formatFrame(_line, sizeof(_line), _frame, _opt.fields);
+        if (_out.push(_line, n)) _counters.samples.inc();
+        else                     _counters.dropped.inc();
+        _subs.broadcast(_line, n);
+    }
+
+    uint64_t now_us = monotonicUs();
+    if (_health.due(now_us)) sendHealth(kStdoutReply, now_us, true);
+    if (_opt.cpu_ms && now_us >= _cpu_next_us) {
+        sendCpu(kStdoutReply);
+        _cpu_next_us = now_us + _opt.cpu_ms * 1000ull;
+    }
+    _stages.lap(proto::Format);
+    _out.flush();       // essential — Python reads line-by-line
+    _stages.lap(proto::Flush);
+    _stages.end(_replaying ? 0 : _timer.period());
+    _health.recordLoop(monotonicNs() - work_start_ns);
+
+    if (now_us >= _end_us) requestStop("duration");
+}
+
+// ── Signals and control channel ────────────────────────────────────────────
+
+void SensorApp::onSignal(void* self, int fd, uint32_t) {
+    SensorApp* app = static_cast<SensorApp*>(self);
+    signalfd_siginfo si;
+    while (read(fd, &si, sizeof(si)) == sizeof(si)) {
+        if (si.ssi_signo == SIGINT || si.ssi_signo == SIGTERM) app->requestStop("signal");
+        if (si.ssi_signo == SIGUSR1) {
+            app->_stages.print(stderr);
+            app->dumpTrace(kStdoutReply);
+        }
+    }
+}
+
+void SensorApp::onConfigWatch(void* self, int, uint32_t) {
+    SensorApp* app = static_cast<SensorApp*>(self);
+    if (app->_config.consumeWatch()) app->reloadConfig();
+}
+
+// Runs on the reactor thread, so it always lands between two samples
+bool SensorApp::reloadConfig() {
+    trace::instant(trace::Reload);
+    char err[128];
+    if (!_config.reload(err, sizeof(err))) {
+        fprintf(stderr, "Config reload failed, keeping current values: %s\n", err);
+        return false;
+    }
+    _pipeline.setAlpha(_config.current().filter_alpha);
+    size_t n = formatConfig(_line, sizeof(_line), _config.current(), _config.source());
+    emit(_line, n);
+    _out.flush();
+    return true;
+}
+
+// Runs between two samples; the copy and write take a few ms at most, so at
+// worst one tick is late
+void SensorApp::dumpTrace(int reply_fd) {
+    size_t events = 0;
+    int n;
+    if (trace::dump(_opt.trace_path, events)) {
+        n = snprintf(_line, sizeof(_line), "#TRACE path=%s events=%zu\n", _opt.trace_path, events);
+    } else {
+        fprintf(stderr, "Trace dump to %s failed: %s\n", _opt.trace_path,
+                _opt.trace_events ? strerror(errno) : "tracing disabled");
+        n = snprintf(_line, sizeof(_line), "#ERROR cmd=TRACE reason=%s\n",
+                     _opt.trace_events ? "write_failed" : "disabled");
+    }
+    reply(reply_fd, _line, static_cast<size_t>(n));
+    _out.flush();
+}
+
+void SensorApp::onControl(void* self, int fd, uint32_t) {
+    SensorApp* app = static_cast<SensorApp*>(self);
+    char*   dst = app->_control.writePtr();
+    ssize_t n   = read(fd, dst, app->_control.writeSpace());
+    if (n <= 0) {
+        if (n < 0 && (errno == EAGAIN || errno == EINTR)) return;
+        app->_reactor.remove(fd);       // consumer closed stdin: keep streaming
+        return;
+    }
+    app->_control.commit(static_cast<size_t>(n));
+
+    const char* line;
+    size_t len;
+    while (app->_control.nextLine(line, len)) app->handleCommand(line, len, kStdoutReply);
+    app->_out.flush();
+}
+
+void SensorApp::onSubscriberLine(void* self, const char* line, size_t len, int fd) {
+    static_cast<SensorApp*>(self)->handleCommand(line, len, fd);
+}
+
+void SensorApp::handleCommand(const char* line, size_t len, int reply_fd) {
+    trace::Span span(trace::Command);
+    Command cmd;
+    const char* error;
+    if (!parseCommand(line, len, cmd, error)) {
+        int word = 0;
+        while (word < static_cast<int>(len) && word < 16 && line[word] != ' ') word++;
+        int n = snprintf(_line, sizeof(_line), "#ERROR cmd=%.*s reason=%s\n",
+                         word, line, error);
+        reply(reply_fd, _line, static_cast<size_t>(n));
+        return;
+    }
+
+    switch (cmd.type) {
+    case CommandType::Hello:
+        sendHello(reply_fd);
+        break;
+    case CommandType::Fields: {
+        // The schema changed for everyone, so every consumer gets a #HELLO
+        _opt.fields = cmd.fields;
+        size_t n = proto::formatHello(_line, sizeof(_line), _opt.fields, _opt.rate_hz,
+                                      _source_name, _opt.health_ms);
+        emit(_line, n);
+        ack(reply_fd, "FIELDS");
+        break;
+    }
+    case CommandType::Health:
+        sendHealth(reply_fd, monotonicUs(), false);
+        break;
+    case CommandType::Config:
+        sendConfig(reply_fd);
+        break;
+    case CommandType::Reload:
+        if (!reloadConfig()) {
+            int n = snprintf(_line, sizeof(_line), "#ERROR cmd=RELOAD reason=invalid_config\n");
+            reply(reply_fd, _line, static_cast<size_t>(n));
+        } else {
+            ack(reply_fd, "RELOAD");
+        }
+        break;
+    case CommandType::Trace:
+        dumpTrace(reply_fd);
+        break;
+    case CommandType::Cpu:
+        sendCpu(reply_fd);
+        break;
+    case CommandType::Quit:
+        ack(reply_fd, "QUIT");
+        requestStop("quit");
+        break;
+    }
+}
+
+void SensorApp::emit(const char* data, size_t len) {
+    _out.push(data, len);
+    _subs.broadcast(data, len);
+}
+
+void SensorApp::reply(int fd, const char* data, size_t len) {
+    if (fd == kStdoutReply) _out.push(data, len);
+    else                    _subs.sendTo(fd, data, len);
+}
+
+// For commands whose effect has no reply of its own
+void SensorApp::ack(int fd, const char* cmd) {
+    int n = snprintf(_line, sizeof(_line), "#ACK cmd=%s\n", cmd);
+    reply(fd, _line, static_cast<size_t>(n));
+}
+
+void SensorApp::sendHello(int fd) {
+    size_t n = proto::formatHello(_line, sizeof(_line), _opt.fields, _opt.rate_hz,
+                                  _source_name, _opt.health_ms);
+    reply(fd, _line, n);
+}
+
+void SensorApp::sendConfig(int fd) {
+    size_t n = formatConfig(_line, sizeof(_line), _config.current(), _config.source());
+    reply(fd, _line, n);
+}
+
+void SensorApp::sendHealth(int fd, uint64_t now_us, bool periodic) {
+    proto::HealthReport h = _health.collect(now_us, _counters, periodic);
+    if (periodic) _gauges.publish(h);
+    size_t n = proto::formatHealth(_line, sizeof(_line), h);
+    if (fd == kStdoutReply) emit(_line, n);
+    else                    reply(fd, _line, n);
+
+    proto::TimingReport t = _stages.collect(periodic);
+    n = proto::formatTiming(_line, sizeof(_line), t);
+    if (fd == kStdoutReply) emit(_line, n);
+    else                    reply(fd, _line, n);
+}
+
+void SensorApp::sendCpu(int fd) {
+    proto::CpuReport r;
+    cpu::collect(r);
+    size_t n = proto::formatCpu(_line, sizeof(_line), r);
+    if (fd == kStdoutReply) emit(_line, n);
+    else                    reply(fd, _line, n);
+}
+
+// Runs on the exporter thread: only atomics and values fixed at setup
+void SensorApp::formatMetrics(void* self, metrics::Exposition& out) {
+    const SensorApp* app = static_cast<const SensorApp*>(self);
+    const HealthCounters& c = app->_counters;
+    const HealthGauges&   g = app->_gauges;
+    char labels[64];
+
+    snprintf(labels, sizeof(labels), "source=\"%s\",proto=\"%d\"", app->_source_name, proto::kVersion);
+    out.family("sensor_info", "gauge", "Sample source and protocol version.");
+    out.sample("sensor_info", labels, uint64_t{1});
+    out.family("sensor_start_time_seconds", "gauge", "Process start, seconds since the epoch.");
+    out.sample("sensor_start_time_seconds", nullptr, app->_start_time_s);
+
+    out.family("sensor_samples_total", "counter", "Data frames queued for output.");
+    out.sample("sensor_samples_total", nullptr, c.samples.value());
+    out.family("sensor_dropped_samples_total", "counter",
+               "Samples lost to missed deadlines, read errors or a full output ring.");
+    out.sample("sensor_dropped_samples_total", nullptr, c.dropped.value());
+    out.family("sensor_i2c_errors_total", "counter", "Failed I2C transactions.");
+    out.sample("sensor_i2c_errors_total", nullptr, c.i2c_errors.value());
+    out.family("sensor_stalls_total", "counter", "Acquisition stalls detected by the watchdog.");
+    out.sample("sensor_stalls_total", nullptr, app->_watchdog.stalls());
+    out.family("sensor_output_overruns_total", "counter", "Lines dropped because stdout was full.");
+    out.sample("sensor_output_overruns_total", nullptr, app->_out.overruns());
+
+    // Interval values from the last periodic #HEALTH (none with --health-ms 0)
+    out.family("sensor_sample_rate_hz", "gauge", "Output data rate over the last health interval.");
+    out.sample("sensor_sample_rate_hz", nullptr, g.odr_hz.value());
+    out.family("sensor_loop_seconds", "gauge", "Loop work time per sample over the last health interval.");
+    out.sample("sensor_loop_seconds", "stat=\"p50\"", g.loop_p50_s.value());
+    out.sample("sensor_loop_seconds", "stat=\"p99\"", g.loop_p99_s.value());
+    out.sample("sensor_loop_seconds", "stat=\"max\"", g.loop_max_s.value());
+    out.family("sensor_wakeup_jitter_seconds", "gauge", "Timer wake-up lateness over the last health interval.");
+    out.sample("sensor_wakeup_jitter_seconds", "stat=\"p50\"", g.jitter_p50_s.value());
+    out.sample("sensor_wakeup_jitter_seconds", "stat=\"p99\"", g.jitter_p99_s.value());
+
+    out.family("sensor_calibration_warm", "gauge", "1 if the calibration was reused from saved state.");
+    out.sample("sensor_calibration_warm", nullptr, g.calibration_warm.value());
+    out.family("sensor_calibration_offset_radians", "gauge", "Neutral head position.");
+    out.sample("sensor_calibration_offset_radians", "axis=\"roll\"",  g.roll_offset.value());
+    out.sample("sensor_calibration_offset_radians", "axis=\"pitch\"", g.pitch_offset.value());
+    out.family("sensor_calibration_spread_radians", "gauge",
+               "Standard deviation while calibrating; high means the head moved.");
+    out.sample("sensor_calibration_spread_radians", "axis=\"roll\"",  g.roll_spread.value());
+    out.sample("sensor_calibration_spread_radians", "axis=\"pitch\"", g.pitch_spread.value());
+
+    // Sampled here, on the exporter thread, rather than by the loop
+    proto::CpuReport cpu;
+    cpu::collect(cpu);
+    out.family("sensor_process_cpu_seconds_total", "counter", "CPU time used by the whole process.");
+    out.sample("sensor_process_cpu_seconds_total", nullptr, cpu.process.cpu_ns / 1e9);
+    out.family("sensor_process_context_switches_total", "counter",
+               "Voluntary switches (wake-ups after blocking) and involuntary ones (preemptions).");
+    out.sample("sensor_process_context_switches_total", "kind=\"voluntary\"", cpu.process.voluntary);
+    out.sample("sensor_process_context_switches_total", "kind=\"involuntary\"", cpu.process.involuntary);
+
+    out.family("sensor_thread_cpu_seconds_total", "counter", "CPU time used by each thread.");
+    for (size_t i = 0; i < cpu.threads; i++) {
+        snprintf(labels, sizeof(labels), "thread=\"%s\"", cpu.name[i]);
+        out.sample("sensor_thread_cpu_seconds_total", labels, cpu.thread[i].cpu_ns / 1e9);
+    }
+    out.family("sensor_thread_context_switches_total", "counter", "Context switches of each thread.");
+    for (size_t i = 0; i < cpu.threads; i++) {
+        snprintf(labels, sizeof(labels), "thread=\"%s\",kind=\"voluntary\"", cpu.name[i]);
+        out.sample("sensor_thread_context_switches_total", labels, cpu.thread[i].voluntary);
+        snprintf(labels, sizeof(labels), "thread=\"%s\",kind=\"involuntary\"", cpu.name[i]);
+        out.sample("sensor_thread_context_switches_total", labels, cpu.thread[i].involuntary);
+    }
+}
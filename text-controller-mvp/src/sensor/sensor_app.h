@@ -0,0 +1,155 @@
+#ifndef SENSOR_APP_H
+#define SENSOR_APP_H
+
+#include <cstdint>
+
+#include "adxl343.h"
+#include "config.h"
+#include "control.h"
+#include "health.h"
+#include "metrics.h"
+#include "output.h"
+#include "pipeline.h"
+#include "protocol.h"
+#include "reactor.h"
+#include "runtime_config.h"
+#include "realtime.h"
+#include "recording.h"
+#include "sample_source.h"
+#include "scheduler.h"
+#include "stage_timer.h"
+#include "subscribers.h"
+#include "trace.h"
+#include "watchdog.h"
+
+struct AppOptions {
+    const char* record_path   = nullptr;
+    const char* replay_path   = nullptr;
+    double      replay_speed  = 1.0;    // 0 = as fast as possible
+    double      replay_from_s = 0.0;    // seconds from start of recording
+    proto::FieldMask fields   = proto::kDefaultFields;
+    unsigned    health_ms     = 1000;   // 0 = no #HEALTH frames
+    unsigned    cpu_ms        = 0;      // #CPU frame period, 0 = on request only
+    double      rate_hz       = 1e9 / 16'000'000;   // ~60 Hz, as before
+    CatchUp     catch_up      = CatchUp::Skip;
+    bool        simulate      = false;
+    double      duration_s    = 0.0;    // 0 = run until signalled
+    const char* socket_path   = nullptr;
+    const char* config_path   = CONFIG_PATH;
+    bool        config_required = false;    // set when --config is given
+    const char* state_path    = STATE_PATH;     // nullptr = don't persist
+    bool        warm_start    = false;
+    unsigned    shutdown_ms   = SHUTDOWN_BUDGET_MS;
+    unsigned    stall_ms      = STALL_TIMEOUT_MS;   // 0 = no watchdog
+    const char* trace_path    = TRACE_PATH;
+    size_t      trace_events  = trace::kDefaultEvents;  // per thread, 0 = off
+    const char* metrics_path  = nullptr;    // Prometheus textfile
+    const char* metrics_socket = nullptr;
+    unsigned    metrics_ms    = METRICS_PERIOD_MS;
+    RealtimeConfig rt;
+};
+
+// The sensor process: one epoll reactor multiplexing the sample timerfd,
+// a signalfd, the stdin control channel and subscriber sockets. Sampling
+// runs as a small state machine (calibrate → settle → stream) driven by
+// timer expirations, so the thread only wakes when there is work.
+class SensorApp {
+public:
+    SensorApp(const AppOptions& opt, ConfigStore& config);
+    ~SensorApp();
+
+    int run();
+
+private:
+    enum class Phase { Calibrating, Settling, Streaming };
+
+    static constexpr int      kCalibrationSamples  = 50;
+    static constexpr uint64_t kCalibrationPeriodNs = 20'000'000;
+    static constexpr uint64_t kSettleNs            = 1'000'000'000;
+    static constexpr int      kReplayBatch         = 64;
+    static constexpr uint64_t kAllocWarmupFrames   = 64;   // then no heap use
+
+    AppOptions       _opt;
+    ConfigStore&     _config;
+    Adxl343          _sensor;
+    LiveSource       _live;
+    SimulatedSource  _simulated;
+    rec::RecordingReader _replay;
+    ReplaySource     _replay_source;
+    SampleSource*    _source;
+    const char*      _source_name;
+    bool             _replaying;
+
+    rec::RecordingWriter _recorder;
+    Pipeline         _pipeline;
+    HealthCounters   _counters;
+    HealthMonitor    _health;
+    HealthGauges     _gauges;
+    metrics::Exporter _metrics;
+    StageTimer       _stages;
+    Watchdog         _watchdog;
+    PeriodicTimer    _timer;
+    OutputWriter     _out;
+    Reactor          _reactor;
+    SubscriberServer _subs;
+    LineBuffer       _control;
+
+    int      _timer_fd;
+    int      _signal_fd;
+    Phase    _phase;
+    int      _cal_count;
+    uint64_t _session_t0_us;
+    uint64_t _end_us;
+    uint64_t _last_t_us;        // timestamp of the last sample handled
+    uint64_t _cpu_next_us;      // next periodic #CPU frame
+    uint64_t _stop_ns;          // when shutdown was requested
+    double   _start_time_s;     // wall clock, for sensor_start_time_seconds
+    const char* _stop_reason;
+    proto::Frame _frame;
+
+    // Replay: the next sample is read ahead so its due time can be armed
+    RawSample _pending;
+    bool      _have_pending;
+    uint64_t  _replay_first_t_us;
+    uint64_t  _replay_wall_t0_ns;
+    bool      _replay_calibrated;   // offsets restored from the recording
+    bool      _replay_warm;         // ... which had no calibration samples
+    uint64_t  _replay_cal_t_us;
+
+    char _line[OutputWriter::kSlotSize];
+
+    bool setup();
+    void finish();
+    void requestStop(const char* reason);
+    void arm(uint64_t deadline_ns);
+    uint64_t replayDueNs(uint64_t t_us);
+
+    void tick();
+    void heartbeat(uint64_t now_ns);
+    void replayTick(uint64_t now_ns);
+    bool restoreRecordedCalibration(uint64_t& from_us);
+    void calibrateStep(const RawSample& s);
+    void finishCalibration(uint64_t t_us);
+    void startStreaming(uint64_t now_ns, bool warm);
+    void streamStep(const RawSample& s, ReadStatus st, uint64_t work_start_ns);
+
+    void handleCommand(const char* line, size_t len, int reply_fd);
+    void emit(const char* data, size_t len);
+    void reply(int fd, const char* data, size_t len);
+    void ack(int fd, const char* cmd);
+    void sendHello(int fd);
+    void sendHealth(int fd, uint64_t now_us, bool periodic);
+    void sendConfig(int fd);
+    void sendCpu(int fd);
+    bool reloadConfig();
+    void dumpTrace(int reply_fd);
+
+    static void onTimer(void* self, int fd, uint32_t events);
+    static void onSignal(void* self, int fd, uint32_t events);
+    static void onConfigWatch(void* self, int fd, uint32_t events);
+    static void onControl(void* self, int fd, uint32_t events);
+    static void onSubscriberLine(void* self, const char* line, size_t len, int fd);
+    static void formatMetrics(void* self, metrics::Exposition& out);
+};
+
+#endif // SENSOR_APP_H
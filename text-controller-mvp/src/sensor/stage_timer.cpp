@@ -0,0 +1,38 @@
+#include "stage_timer.h"
+
+void StageTimer::reset() {
+    for (int i = 0; i < proto::StageCount; i++) {
+        _interval[i].reset();
+        _total[i].reset();
+    }
+    _overruns = 0;
+}
+
+proto::TimingReport StageTimer::collect(bool reset) {
+    proto::TimingReport t{};
+    for (int i = 0; i < proto::StageCount; i++) {
+        Histogram& h = _interval[i];
+        t.stage[i] = { h.percentile(0.50) / 1e3, h.percentile(0.99) / 1e3,
+                       h.percentile(0.999) / 1e3 };
+        if (reset) {
+            _total[i].merge(h);
+            h.reset();
+        }
+    }
+    t.overruns = _overruns;
+    return t;
+}
+
+void StageTimer::print(FILE* out) const {
+    fprintf(out, "Loop stages since start (us), %llu overruns:\n",
+            static_cast<unsigned long long>(_overruns));
+    fprintf(out, "  %-8s %10s %9s %9s %9s %9s\n", "stage", "n", "p50", "p99", "p99.9", "max");
+    for (int i = 0; i < proto::StageCount; i++) {
+        Histogram h = _total[i];
+        h.merge(_interval[i]);
+        fprintf(out, "  %-8s %10llu %9.2f %9.2f %9.2f %9.2f\n", proto::kStageNames[i],
+                static_cast<unsigned long long>(h.count()),
+                h.percentile(0.50) / 1e3, h.percentile(0.99) / 1e3,
+                h.percentile(0.999) / 1e3, h.max() / 1e3);
+    }
+}
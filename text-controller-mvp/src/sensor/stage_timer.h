@@ -0,0 +1,51 @@
+#ifndef STAGE_TIMER_H
+#define STAGE_TIMER_H
+
+#include <cstdint>
+#include <cstdio>
+
+#include "clock.h"
+#include "histogram.h"
+#include "protocol.h"
+#include "trace.h"
+
+// Per-stage timing of the streaming loop. begin() and one lap() per stage
+// cost a CLOCK_MONOTONIC_RAW read, an O(1) histogram insert and, on a
+// traced thread, one trace event (see trace.h) each, so it
+// stays on in production. Interval histograms feed the periodic #TIMING
+// frame and are folded into since-start totals for print().
+class StageTimer {
+public:
+    StageTimer() : _last_ns(0), _begin_ns(0), _overruns(0) {}
+
+    void begin() { _last_ns = _begin_ns = rawClockNs(); }
+
+    void lap(proto::Stage s) {
+        uint64_t now = rawClockNs();
+        _interval[s].record(now - _last_ns);
+        trace::complete(static_cast<trace::Name>(s), _last_ns, now);
+        _last_ns = now;
+    }
+
+    // End of one iteration; budget_ns = 0 disables overrun counting
+    void end(uint64_t budget_ns) {
+        if (budget_ns && _last_ns - _begin_ns > budget_ns) _overruns++;
+    }
+
+    void reset();
+
+    // Percentiles for the interval so far; reset = true starts a new one
+    proto::TimingReport collect(bool reset);
+
+    // Since-start table (including the current interval)
+    void print(FILE* out) const;
+
+private:
+    uint64_t  _last_ns;
+    uint64_t  _begin_ns;
+    uint64_t  _overruns;
+    Histogram _interval[proto::StageCount];
+    Histogram _total[proto::StageCount];
+};
+
+#endif // STAGE_TIMER_H
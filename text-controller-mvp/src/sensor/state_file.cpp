@@ -0,0 +1,67 @@
+#include "state_file.h"
+#include "clock.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+static constexpr int kStateVersion = 1;
+
+bool saveState(const char* path, const PersistedState& s) {
+    char tmp[256];
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= static_cast<int>(sizeof(tmp))) return false;
+
+    FILE* f = fopen(tmp, "w");
+    if (!f) {
+        perror("Failed to write sensor state");
+        return false;
+    }
+    fprintf(f, "version=%d\n", kStateVersion);
+    fprintf(f, "saved_realtime_us=%llu\n", static_cast<unsigned long long>(s.saved_realtime_us));
+    fprintf(f, "roll_offset=%.9g\n",    s.pipeline.roll_offset);
+    fprintf(f, "pitch_offset=%.9g\n",   s.pipeline.pitch_offset);
+    fprintf(f, "filtered_roll=%.9g\n",  s.pipeline.filtered_roll);
+    fprintf(f, "filtered_pitch=%.9g\n", s.pipeline.filtered_pitch);
+
+    bool ok = fflush(f) == 0 && fsync(fileno(f)) == 0;
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(tmp, path) != 0) {
+        perror("Failed to write sensor state");
+        unlink(tmp);
+        return false;
+    }
+    return true;
+}
+
+bool loadState(const char* path, uint64_t max_age_s, PersistedState& out) {
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+
+    PersistedState s = {};
+    int version = 0, seen = 0;
+    char key[64];
+    double value;
+    unsigned long long saved = 0;
+    char line[128];
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "saved_realtime_us=%llu", &saved) == 1) { seen++; continue; }
+        if (sscanf(line, "%63[^=]=%lf", key, &value) != 2) continue;
+        if      (!strcmp(key, "version"))        { version = static_cast<int>(value); continue; }
+        else if (!strcmp(key, "roll_offset"))    s.pipeline.roll_offset    = static_cast<float>(value);
+        else if (!strcmp(key, "pitch_offset"))   s.pipeline.pitch_offset   = static_cast<float>(value);
+        else if (!strcmp(key, "filtered_roll"))  s.pipeline.filtered_roll  = static_cast<float>(value);
+        else if (!strcmp(key, "filtered_pitch")) s.pipeline.filtered_pitch = static_cast<float>(value);
+        else continue;
+        seen++;
+    }
+    fclose(f);
+
+    if (version != kStateVersion || seen != 5) return false;
+    s.saved_realtime_us = saved;
+
+    uint64_t now = realtimeUs();
+    if (saved > now || now - saved > max_age_s * 1'000'000ull) return false;
+    out = s;
+    return true;
+}
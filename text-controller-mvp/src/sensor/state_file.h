@@ -0,0 +1,20 @@
+#ifndef STATE_FILE_H
+#define STATE_FILE_H
+
+#include <cstdint>
+
+#include "pipeline.h"
+
+// Calibration and filter state persisted across restarts as a small
+// key=value text file, replaced atomically (write temp, fsync, rename).
+struct PersistedState {
+    Pipeline::State pipeline;
+    uint64_t        saved_realtime_us;
+};
+
+bool saveState(const char* path, const PersistedState& s);
+
+// False if the file is missing, malformed or older than max_age_s.
+bool loadState(const char* path, uint64_t max_age_s, PersistedState& out);
+
+#endif // STATE_FILE_H
@@ -0,0 +1,136 @@
+#include "subscribers.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+SubscriberServer::SubscriberServer()
+    : _listen_fd(-1), _path{}, _reactor(nullptr), _fn(nullptr), _ctx(nullptr), _dropped(0) {
+    for (Client& c : _clients) {
+        c.server = this;
+        c.fd     = -1;
+    }
+}
+
+SubscriberServer::~SubscriberServer() {
+    close();
+}
+
+bool SubscriberServer::listen(const char* path, Reactor& reactor, LineFn fn, void* ctx) {
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", path);
+        return false;
+    }
+    strcpy(addr.sun_path, path);
+    strcpy(_path, path);
+
+    _listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (_listen_fd < 0) {
+        perror("Failed to create subscriber socket");
+        return false;
+    }
+    unlink(path);       // stale socket from a previous run
+    if (bind(_listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0
+            || ::listen(_listen_fd, 4) < 0) {
+        perror("Failed to listen on subscriber socket");
+        close();
+        return false;
+    }
+
+    _reactor = &reactor;
+    _fn      = fn;
+    _ctx     = ctx;
+    if (!reactor.add(_listen_fd, EPOLLIN, onAccept, this)) {
+        close();
+        return false;
+    }
+    fprintf(stderr, "Serving subscribers on %s\n", path);
+    return true;
+}
+
+void SubscriberServer::close() {
+    for (Client& c : _clients)
+        if (c.fd >= 0) drop(c);
+    if (_listen_fd >= 0) {
+        if (_reactor) _reactor->remove(_listen_fd);
+        ::close(_listen_fd);
+        unlink(_path);
+        _listen_fd = -1;
+    }
+}
+
+void SubscriberServer::onAccept(void* self, int fd, uint32_t) {
+    SubscriberServer* s = static_cast<SubscriberServer*>(self);
+    for (;;) {
+        int cfd = accept4(fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (cfd < 0) return;    // EAGAIN: backlog drained
+
+        Client* slot = nullptr;
+        for (Client& c : s->_clients)
+            if (c.fd < 0) { slot = &c; break; }
+        if (!slot || !s->_reactor->add(cfd, EPOLLIN | EPOLLRDHUP, onClient, slot)) {
+            ::close(cfd);
+            continue;
+        }
+        slot->fd = cfd;
+        slot->in = LineBuffer();
+        s->_fn(s->_ctx, "HELLO", 5, cfd);
+    }
+}
+
+void SubscriberServer::onClient(void* client, int fd, uint32_t events) {
+    Client& c = *static_cast<Client*>(client);
+    SubscriberServer* s = c.server;
+
+    char*   dst = c.in.writePtr();
+    ssize_t n   = read(fd, dst, c.in.writeSpace());
+    if (n <= 0 && !(n < 0 && errno == EAGAIN)) {
+        s->drop(c);
+        return;
+    }
+    if (n > 0) {
+        c.in.commit(static_cast<size_t>(n));
+        const char* line;
+        size_t len;
+        while (c.fd >= 0 && c.in.nextLine(line, len)) s->_fn(s->_ctx, line, len, fd);
+    }
+    if (c.fd >= 0 && (events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR))) s->drop(c);
+}
+
+void SubscriberServer::drop(Client& c) {
+    _reactor->remove(c.fd);
+    ::close(c.fd);
+    c.fd = -1;
+}
+
+void SubscriberServer::sendTo(int fd, const char* data, size_t len) {
+    for (Client& c : _clients) {
+        if (c.fd != fd) continue;
+        ssize_t n = send(fd, data, len, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (n == static_cast<ssize_t>(len)) return;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            _dropped++;
+            return;
+        }
+        drop(c);        // error or partial line
+        return;
+    }
+}
+
+void SubscriberServer::broadcast(const char* data, size_t len) {
+    for (Client& c : _clients)
+        if (c.fd >= 0) sendTo(c.fd, data, len);
+}
+
+size_t SubscriberServer::clientCount() const {
+    size_t n = 0;
+    for (const Client& c : _clients)
+        if (c.fd >= 0) n++;
+    return n;
+}
@@ -0,0 +1,54 @@
+#ifndef SUBSCRIBERS_H
+#define SUBSCRIBERS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "control.h"
+#include "reactor.h"
+
+// Local Unix-socket fan-out of the stdout stream. Each client gets the same
+// lines and may send control commands. Sends never block the sampling
+// loop: a client whose socket buffer is full misses lines, and one that
+// only accepts part of a line is disconnected to keep framing intact.
+class SubscriberServer {
+public:
+    static constexpr size_t kMaxClients = 8;
+
+    // Invoked for each command line from a client, and with "HELLO" when
+    // a client connects; reply with sendTo(client_fd, ...).
+    using LineFn = void (*)(void* ctx, const char* line, size_t len, int client_fd);
+
+    SubscriberServer();
+    ~SubscriberServer();
+
+    bool listen(const char* path, Reactor& reactor, LineFn fn, void* ctx);
+    void close();
+
+    void broadcast(const char* data, size_t len);
+    void sendTo(int fd, const char* data, size_t len);
+
+    size_t   clientCount() const;
+    uint64_t droppedLines() const { return _dropped; }
+
+private:
+    struct Client {
+        SubscriberServer* server;
+        int               fd;
+        LineBuffer        in;
+    };
+
+    int      _listen_fd;
+    char     _path[108];
+    Reactor* _reactor;
+    LineFn   _fn;
+    void*    _ctx;
+    uint64_t _dropped;
+    Client   _clients[kMaxClients];
+
+    static void onAccept(void* self, int fd, uint32_t events);
+    static void onClient(void* client, int fd, uint32_t events);
+    void drop(Client& c);
+};
+
+#endif // SUBSCRIBERS_H
@@ -0,0 +1,204 @@
+#include "trace.h"
+#include "arena.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+namespace trace {
+
+namespace {
+
+Arena                 g_arena;
+ThreadBuffer          g_threads[kMaxThreads];
+std::atomic<uint32_t> g_attached{0};
+size_t                g_capacity = 0;      // events per ring, power of two
+Event*                g_scratch  = nullptr; // one ring's worth, for dump()
+
+const char* const kNames[NameCount] = {
+    "read", "math", "filter", "format", "flush",
+    "write", "command", "stall", "reload",
+};
+
+bool writeAll(int fd, const void* data, size_t len) {
+    const char* p = static_cast<const char*>(data);
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p   += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+void copyName(char (&dst)[kNameLen], const char* src) {
+    strncpy(dst, src, kNameLen - 1);
+    dst[kNameLen - 1] = '\0';
+}
+
+} // namespace
+
+bool init(size_t events) {
+    release();
+    if (events == 0) return true;
+
+    size_t cap = 1;
+    while (cap < events) cap <<= 1;
+    if (!g_arena.init((kMaxThreads + 1) * cap * sizeof(Event))) return false;
+    // Rings are carved up front: attachThread() may race with other threads
+    for (ThreadBuffer& b : g_threads) b.events = g_arena.allocArray<Event>(cap);
+    g_scratch  = g_arena.allocArray<Event>(cap);
+    g_capacity = cap;
+    return true;
+}
+
+void release() {
+    g_capacity = 0;
+    g_scratch  = nullptr;
+    g_attached.store(0, std::memory_order_relaxed);
+    for (ThreadBuffer& b : g_threads) b.ready.store(false, std::memory_order_relaxed);
+    g_arena.release();
+}
+
+bool attachThread(const char* name) {
+    if (g_capacity == 0 || t_buffer) return t_buffer != nullptr;
+    uint32_t i = g_attached.fetch_add(1, std::memory_order_relaxed);
+    if (i >= kMaxThreads) return false;
+
+    ThreadBuffer& b = g_threads[i];
+    b.mask   = g_capacity - 1;
+    b.tid    = static_cast<int32_t>(syscall(SYS_gettid));
+    copyName(b.name, name);
+    b.head.store(0, std::memory_order_relaxed);
+    b.ready.store(true, std::memory_order_release);
+    t_buffer = &b;
+    return true;
+}
+
+// Snapshot each ring into the scratch buffer before writing, then drop
+// whatever the owner overwrote while it was being copied.
+bool dump(const char* path, size_t& events) {
+    events = 0;
+    if (g_capacity == 0) return false;
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+
+    uint32_t threads = 0;
+    for (const ThreadBuffer& b : g_threads)
+        if (b.ready.load(std::memory_order_acquire)) threads++;
+
+    FileHeader fh = {};
+    memcpy(fh.magic, kMagic, sizeof(kMagic));
+    fh.version      = kVersion;
+    fh.pid          = static_cast<uint32_t>(getpid());
+    uint64_t raw0   = rawClockNs();
+    fh.monotonic_ns = monotonicNs();
+    fh.raw_ns       = raw0 + (rawClockNs() - raw0) / 2;
+    fh.threads      = threads;
+    fh.names        = NameCount;
+
+    char names[NameCount][kNameLen] = {};
+    for (int i = 0; i < NameCount; i++) copyName(names[i], kNames[i]);
+    bool ok = writeAll(fd, &fh, sizeof(fh)) && writeAll(fd, names, sizeof(names));
+
+    for (ThreadBuffer& b : g_threads) {
+        if (!ok) break;
+        if (!b.ready.load(std::memory_order_acquire)) continue;
+
+        uint64_t head  = b.head.load(std::memory_order_acquire);
+        uint64_t first = head > g_capacity ? head - g_capacity : 0;
+        for (uint64_t i = first; i < head; i++) g_scratch[i - first] = b.events[i & b.mask];
+
+        // The owner kept writing: entries it has lapped since are stale, and
+        // so is the one at `now`, which it may be overwriting as we copy
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t now   = b.head.load(std::memory_order_relaxed);
+        uint64_t valid = now >= g_capacity ? now - g_capacity + 1 : 0;
+        uint64_t skip  = valid > first ? valid - first : 0;
+        if (skip > head - first) skip = head - first;
+
+        ThreadHeader th = {};
+        th.tid   = b.tid;
+        th.count = static_cast<uint32_t>(head - first - skip);
+        th.lost  = first + skip;
+        memcpy(th.name, b.name, kNameLen);
+        ok = writeAll(fd, &th, sizeof(th))
+          && writeAll(fd, g_scratch + skip, th.count * sizeof(Event));
+        events += th.count;
+    }
+
+    if (close(fd) != 0) ok = false;
+    return ok;
+}
+
+// ── Conversion ─────────────────────────────────────────────────────────────
+
+bool toJson(const char* path, FILE* out) {
+    FILE* in = fopen(path, "rb");
+    if (!in) {
+        perror("Failed to open trace");
+        return false;
+    }
+
+    FileHeader fh;
+    char       names[256][kNameLen];
+    bool ok = fread(&fh, sizeof(fh), 1, in) == 1
+           && memcmp(fh.magic, kMagic, sizeof(kMagic)) == 0
+           && fh.version == kVersion && fh.names <= 256
+           && fread(names, kNameLen, fh.names, in) == fh.names;
+    if (!ok) {
+        fprintf(stderr, "%s: not a sensor trace (version %u expected)\n", path, kVersion);
+        fclose(in);
+        return false;
+    }
+    for (uint32_t i = 0; i < fh.names; i++) names[i][kNameLen - 1] = '\0';
+
+    // Raw-clock stamps onto CLOCK_MONOTONIC; the drift between the two over
+    // one ring is a few ppm, well under the resolution that matters here
+    int64_t offset = static_cast<int64_t>(fh.monotonic_ns - fh.raw_ns);
+
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+                 "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,\"args\":{\"name\":\"sensor\"}}",
+            fh.pid);
+    for (uint32_t t = 0; ok && t < fh.threads; t++) {
+        ThreadHeader th;
+        if (fread(&th, sizeof(th), 1, in) != 1) {
+            ok = false;
+            break;
+        }
+        th.name[kNameLen - 1] = '\0';
+        fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%d,"
+                     "\"args\":{\"name\":\"%s\",\"lost\":%llu}}",
+                fh.pid, th.tid, th.name, static_cast<unsigned long long>(th.lost));
+
+        Event e;
+        for (uint32_t i = 0; i < th.count; i++) {
+            if (fread(&e, sizeof(e), 1, in) != 1) {
+                ok = false;
+                break;
+            }
+            const char* name = e.name < fh.names ? names[e.name] : "unknown";
+            double ts_us = (static_cast<int64_t>(e.ts_ns) + offset) / 1e3;
+            if (e.phase == Complete)
+                fprintf(out, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%u,\"tid\":%d,"
+                             "\"ts\":%.3f,\"dur\":%.3f}",
+                        name, fh.pid, th.tid, ts_us, e.value / 1e3);
+            else
+                fprintf(out, ",\n{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":%u,\"tid\":%d,"
+                             "\"ts\":%.3f,\"args\":{\"value\":%u}}",
+                        name, fh.pid, th.tid, ts_us, e.value);
+        }
+    }
+    fprintf(out, "\n]}\n");
+    fclose(in);
+    if (!ok) fprintf(stderr, "%s: truncated trace\n", path);
+    return ok;
+}
+
+} // namespace trace
@@ -0,0 +1,140 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Timeline tracing: a flight recorder of the last few thousand events per
+// thread, dumped on demand (SIGUSR1 or the TRACE command) and converted to
+// Chrome trace-event JSON for chrome://tracing or ui.perfetto.dev.
+//
+// Each thread that calls attachThread() gets its own ring of 16-byte
+// events, written without locks or atomics RMW: one store of the event and
+// a release store of the head. Threads that never attach record nothing,
+// and with init(0) no thread can attach, so every call below is a TLS load
+// and a branch. Timestamps are CLOCK_MONOTONIC_RAW, shared with StageTimer
+// so loop stages cost no extra clock reads; the converter maps them onto
+// CLOCK_MONOTONIC, the clock the app's own timeline uses.
+//
+// Dump file (native endian):
+//   FileHeader, NameCount × char[16] names,
+//   then per thread: ThreadHeader, Event[count] (oldest first)
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include "clock.h"
+#include "protocol.h"
+
+namespace trace {
+
+// proto::Stage values first, so StageTimer laps map one to one
+enum Name : uint16_t {
+    Read, Math, Filter, Format, Flush,
+    Write,          // output thread: one drain() burst
+    Command,        // control command handled
+    Stall,          // watchdog level change, value = 1 warn, 2 reset, 3 exit, 0 recovered
+    Reload,         // config reload
+    NameCount
+};
+static_assert(Read == static_cast<int>(proto::Read) && Flush == static_cast<int>(proto::Flush),
+              "trace names must start with the loop stages");
+
+enum Phase : uint8_t {
+    Complete = 'X',     // value = duration in ns
+    Instant  = 'i',     // value = argument
+};
+
+struct Event {
+    uint64_t ts_ns;
+    uint32_t value;
+    uint16_t name;
+    uint8_t  phase;
+    uint8_t  reserved;
+};
+static_assert(sizeof(Event) == 16, "events are packed 16 bytes");
+
+constexpr char     kMagic[8]     = { 'S', 'N', 'S', 'T', 'R', 'A', 'C', 'E' };
+constexpr uint32_t kVersion      = 1;
+constexpr size_t   kMaxThreads   = 8;
+constexpr size_t   kNameLen      = 16;
+constexpr size_t   kDefaultEvents = 8192;  // per thread, ~2 min of the loop at 62.5 Hz
+
+struct FileHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t pid;
+    uint64_t raw_ns;            // the same instant on both clocks, taken at dump
+    uint64_t monotonic_ns;
+    uint32_t threads;
+    uint32_t names;
+};
+
+struct ThreadHeader {
+    int32_t  tid;
+    uint32_t count;
+    uint64_t lost;              // overwritten since the thread attached
+    char     name[kNameLen];
+};
+
+struct ThreadBuffer {
+    std::atomic<bool>     ready;    // set once the fields below are filled in
+    std::atomic<uint64_t> head;
+    Event*   events;
+    uint64_t mask;
+    int32_t  tid;
+    char     name[kNameLen];
+};
+
+// The calling thread's ring; nullptr until attachThread()
+inline thread_local ThreadBuffer* t_buffer = nullptr;
+
+// Reserve rings for up to kMaxThreads threads of `events` each (rounded up
+// to a power of two), in one mapping. Call before any thread attaches.
+// 0 disables tracing. release() only once every traced thread has exited.
+bool init(size_t events);
+void release();
+
+// Give the calling thread a ring. False when disabled or out of rings.
+bool attachThread(const char* name);
+
+inline void record(Name name, Phase phase, uint64_t ts_ns, uint32_t value) {
+    ThreadBuffer* b = t_buffer;
+    if (!b) return;
+    uint64_t h = b->head.load(std::memory_order_relaxed);
+    b->events[h & b->mask] = { ts_ns, value, name, phase, 0 };
+    b->head.store(h + 1, std::memory_order_release);
+}
+
+inline void complete(Name name, uint64_t start_ns, uint64_t end_ns) {
+    uint64_t d = end_ns - start_ns;
+    record(name, Complete, start_ns, d > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(d));
+}
+
+inline void instant(Name name, uint32_t value = 0) {
+    if (t_buffer) record(name, Instant, rawClockNs(), value);
+}
+
+// Complete event covering the enclosing scope
+class Span {
+public:
+    explicit Span(Name name) : _name(name), _start(t_buffer ? rawClockNs() : 0) {}
+    ~Span() { if (_start) complete(_name, _start, rawClockNs()); }
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+private:
+    Name     _name;
+    uint64_t _start;
+};
+
+// Write every ring to `path` (O_TRUNC, no stdio or heap, so it is safe on
+// the loop thread; rings keep recording meanwhile). `events` gets the
+// number written.
+bool dump(const char* path, size_t& events);
+
+// Convert a dump to Chrome trace-event JSON
+bool toJson(const char* path, FILE* out);
+
+} // namespace trace
+
+#endif // TRACE_H
@@ -0,0 +1,139 @@
+#include "watchdog.h"
+#include "clock.h"
+#include "config.h"
+#include "cpu_usage.h"
+#include "trace.h"
+
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <unistd.h>
+
+static constexpr size_t   kWatchdogStack = 64 * 1024;
+static constexpr uint64_t kMinPollNs     = 1'000'000;
+static constexpr int      kExitFlushMs   = 100;     // let the #BYE reach the pipe
+
+// Only there to make a blocked syscall return EINTR
+static void onInterrupt(int) {}
+
+Watchdog::Watchdog()
+    : _thread(), _target(), _running(false), _stall_ns(0), _rt(), _out(nullptr),
+      _beat_ns(0), _reset(false), _stop(false), _stalls(0) {}
+
+Watchdog::~Watchdog() {
+    stop();
+}
+
+bool Watchdog::start(unsigned stall_ms, const RealtimeConfig& rt, OutputWriter& out) {
+    if (stall_ms == 0 || _running) return true;
+    _stall_ns = stall_ms * 1'000'000ull;
+    _rt       = rt;
+    _out      = &out;
+    _target   = pthread_self();
+    _beat_ns.store(monotonicNs(), std::memory_order_relaxed);
+
+    // No SA_RESTART: an interrupted I2C read must fail, not resume blocking
+    struct sigaction sa = {};
+    sa.sa_handler = onInterrupt;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGUSR2, &sa, nullptr);
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, kWatchdogStack);
+    int rc = pthread_create(&_thread, &attr, threadMain, this);
+    pthread_attr_destroy(&attr);
+    if (rc != 0) {
+        fprintf(stderr, "Failed to start watchdog thread: %s\n", strerror(rc));
+        return false;
+    }
+    _running = true;
+    return true;
+}
+
+void Watchdog::stop() {
+    if (!_running) return;
+    _stop.store(true, std::memory_order_release);
+    pthread_join(_thread, nullptr);
+    _running = false;
+}
+
+void* Watchdog::threadMain(void* self) {
+    static_cast<Watchdog*>(self)->run();
+    return nullptr;
+}
+
+void Watchdog::run() {
+    superviseCurrentThread(_rt);
+    trace::attachThread("watchdog");
+    cpu::attachThread("watchdog");
+
+    // Poll at a quarter of the timeout: detection lands within 1.25 × stall_ms
+    uint64_t poll_ns = _stall_ns / 4 > kMinPollNs ? _stall_ns / 4 : kMinPollNs;
+    timespec poll = { static_cast<time_t>(poll_ns / 1'000'000'000ull),
+                      static_cast<long>(poll_ns % 1'000'000'000ull) };
+
+    int      level       = 0;     // 0 ok, 1 warned, 2 reset requested
+    uint64_t stalled_at  = 0;     // heartbeat the stall started from
+    while (!_stop.load(std::memory_order_acquire)) {
+        clock_nanosleep(CLOCK_MONOTONIC, 0, &poll, nullptr);
+
+        uint64_t now  = monotonicNs();
+        uint64_t beat = _beat_ns.load(std::memory_order_acquire);
+
+        if (level > 0 && beat != stalled_at) {
+            _durations.record(beat - stalled_at);
+            report("recovered", beat - stalled_at);
+            trace::instant(trace::Stall, 0);
+            level = 0;
+        }
+
+        uint64_t silent = now > beat ? now - beat : 0;
+        if (level == 0 && silent >= _stall_ns) {
+            level      = 1;
+            stalled_at = beat;
+            _stalls.fetch_add(1, std::memory_order_relaxed);
+            report("warn", silent);
+            trace::instant(trace::Stall, 1);
+        }
+        if (level == 1 && silent >= _stall_ns * STALL_RESET_FACTOR) {
+            level = 2;
+            _reset.store(true, std::memory_order_release);
+            pthread_kill(_target, SIGUSR2);
+            report("reset", silent);
+            trace::instant(trace::Stall, 2);
+        }
+        if (level == 2 && silent >= _stall_ns * STALL_EXIT_FACTOR)
+            giveUp(silent);
+    }
+    cpu::detachThread();
+}
+
+void Watchdog::report(const char* level, uint64_t stalled_ns) {
+    char line[OutputWriter::kSlotSize];
+    int n = snprintf(line, sizeof(line), "#STALL level=%s stalled_ms=%.1f stalls=%llu\n",
+                     level, stalled_ns / 1e6,
+                     static_cast<unsigned long long>(stalls()));
+    fputs(line + 1, stderr);
+    _out->postUrgent(line, static_cast<size_t>(n));
+}
+
+void Watchdog::giveUp(uint64_t stalled_ns) {
+    report("exit", stalled_ns);
+    trace::instant(trace::Stall, 3);
+    for (int i = 0; i < kExitFlushMs && _out->urgentPending(); i++) usleep(1000);
+
+    char line[64];
+    int n = snprintf(line, sizeof(line), "#BYE reason=stall shutdown_ms=0.0\n");
+    _out->postUrgent(line, static_cast<size_t>(n));
+    for (int i = 0; i < kExitFlushMs && _out->urgentPending(); i++) usleep(1000);
+
+    fprintf(stderr, "Acquisition stalled for %.0f ms, exiting\n", stalled_ns / 1e6);
+    _exit(kExitStalled);
+}
+
+void Watchdog::print(FILE* out) const {
+    fprintf(out, "Stalls: %llu\n", static_cast<unsigned long long>(stalls()));
+    if (_durations.count() > 0)
+        _durations.print(out, "Stall duration", 1e6, "ms");
+}
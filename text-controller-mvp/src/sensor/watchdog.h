@@ -0,0 +1,70 @@
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <pthread.h>
+
+#include "histogram.h"
+#include "output.h"
+#include "realtime.h"
+
+// Exit status when the watchdog gives up on a hung acquisition thread
+constexpr int kExitStalled = 3;
+
+// Supervises the acquisition thread's heartbeat from a separate thread.
+// A blocked I2C transfer (clock-stretching glitch) otherwise freezes the
+// whole binary, which the consumer cannot tell apart from a still head.
+//
+// Escalation, measured from the last heartbeat:
+//   stall_ms                   #STALL level=warn
+//   stall_ms × RESET_FACTOR    #STALL level=reset — SIGUSR2 interrupts the
+//                              blocked syscall and the acquisition thread
+//                              reopens the bus (takeReset())
+//   stall_ms × EXIT_FACTOR     #STALL level=exit, #BYE, exit(kExitStalled)
+// and #STALL level=recovered when heartbeats resume.
+//
+// The exit path runs on the watchdog thread while the acquisition thread
+// is stuck, so it skips state persistence and the recording footer; the
+// recording stays readable by block scan.
+class Watchdog {
+public:
+    Watchdog();
+    ~Watchdog();
+
+    // Supervise the calling thread. stall_ms = 0 disables the watchdog.
+    bool start(unsigned stall_ms, const RealtimeConfig& rt, OutputWriter& out);
+    void stop();
+
+    // Acquisition thread, once per tick
+    void beat(uint64_t now_ns) { _beat_ns.store(now_ns, std::memory_order_release); }
+    bool takeReset() { return _reset.load(std::memory_order_relaxed)
+                              && _reset.exchange(false, std::memory_order_acq_rel); }
+
+    uint64_t stalls() const { return _stalls.load(std::memory_order_relaxed); }
+
+    // Stall count and duration histogram; call after stop()
+    void print(FILE* out) const;
+
+private:
+    pthread_t      _thread;
+    pthread_t      _target;
+    bool           _running;
+    uint64_t       _stall_ns;
+    RealtimeConfig _rt;
+    OutputWriter*  _out;
+
+    alignas(64) std::atomic<uint64_t> _beat_ns;
+    std::atomic<bool>     _reset;
+    std::atomic<bool>     _stop;
+    std::atomic<uint64_t> _stalls;
+    Histogram             _durations;      // watchdog thread only
+
+    static void* threadMain(void* self);
+    void run();
+    void report(const char* level, uint64_t stalled_ns);
+    [[noreturn]] void giveUp(uint64_t stalled_ns);
+};
+
+#endif // WATCHDOG_H